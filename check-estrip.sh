@@ -0,0 +1,75 @@
+#!/bin/sh
+# Copyright 2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Check that estrip turns a transcript of eparallel with the status
+# board into the same plain text as one without it: every board frame
+# and the carriage returns of its moves gone. The transcripts are taken
+# on a pty, which needs python3. Run by make check, from the top of a
+# built tree.
+#
+
+tmp="${TMPDIR:-/tmp}/check-estrip.$$"
+trap 'rm -rf "${tmp}"' EXIT
+mkdir -p "${tmp}" || exit 1
+
+if ! command -v python3 >/dev/null 2>&1; then
+	echo "estrip: skipped, python3 is needed for the pty"
+	exit 0
+fi
+
+cat > "${tmp}/run.sh" <<'EOF'
+. "${FUNCTIONS}"
+einfo "before"
+eparallel -j 3 "one" "sleep 0.3; echo one" "two" "sleep 0.1; echo two" \
+	"three with a name" "sleep 0.5" "four" "false" \
+	"five" "sleep 0.2; echo five"
+einfo "after"
+EOF
+
+# Run the shell on a pty, without turning newlines into CR LF, and copy
+# what it shows to stdout
+cat > "${tmp}/record.py" <<'EOF'
+import os, pty, sys, termios
+
+pid, fd = pty.fork()
+if pid == 0:
+    attr = termios.tcgetattr(0)
+    attr[1] &= ~termios.OPOST
+    termios.tcsetattr(0, termios.TCSANOW, attr)
+    os.execvp(sys.argv[1], sys.argv[1:])
+while True:
+    try:
+        data = os.read(fd, 65536)
+    except OSError:
+        break
+    if not data:
+        break
+    os.write(1, data)
+os.waitpid(pid, 0)
+EOF
+
+for board in yes no; do
+	FUNCTIONS="${PWD}/functions.sh" GENTOO_FUNCTIONS_LIBEXECDIR="${PWD}" \
+		EINFO_BOARD="${board}" COLUMNS=60 TERM=xterm \
+		python3 "${tmp}/record.py" sh "${tmp}/run.sh" \
+		> "${tmp}/${board}.raw"
+	./estrip "${tmp}/${board}.raw" > "${tmp}/${board}.txt"
+done
+
+ret=0
+if ! grep -q "$(printf '\033')\\[J" "${tmp}/yes.raw"; then
+	echo "estrip: the board was not drawn"
+	ret=1
+elif ! cmp -s "${tmp}/no.txt" "${tmp}/yes.txt"; then
+	echo "estrip: the board transcript differs:"
+	diff -u "${tmp}/no.txt" "${tmp}/yes.txt"
+	ret=1
+elif tr -d '\r' < "${tmp}/yes.txt" | cmp -s - "${tmp}/yes.txt"; then
+	echo "estrip: board transcript is plain text"
+else
+	echo "estrip: carriage returns left in the board transcript"
+	ret=1
+fi
+exit ${ret}
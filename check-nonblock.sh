@@ -0,0 +1,97 @@
+#!/bin/sh
+# Copyright 2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Check that with EINFO_NONBLOCK the e-functions never wait for a
+# console that nobody reads: the script runs on a pty whose other end
+# is never read, and has to finish all the same. Messages, warnings and
+# failed spans are all tried, with stderr on the pty and on a FIFO
+# nobody reads. Needs python3 for the pty. Run by make check, from the
+# top of a built tree.
+#
+
+VARIANTS="$*"
+tmp="${TMPDIR:-/tmp}/check-nonblock.$$"
+trap 'rm -rf "${tmp}"' EXIT
+mkdir -p "${tmp}/generic" "${tmp}/run" || exit 1
+
+if ! command -v python3 >/dev/null 2>&1; then
+	echo "nonblock: skipped, python3 is needed for the pty"
+	exit 0
+fi
+
+ln -s "${PWD}/functions.sh" "${PWD}/functions" "${PWD}/econsole" \
+	"${tmp}/generic/"
+
+cat > "${tmp}/run.sh" <<'EOF'
+. "${FUNCTIONS}"
+case "$1" in
+	fifo) exec 2>"${FIFO}";;
+esac
+for f in einfo ewarn eend ; do
+	i=0
+	while [ "${i}" -lt 2000 ] ; do
+		case "${f}" in
+			eend)
+				ebegin "step ${i}"
+				eend 1 "step ${i} failed, and says why"
+				;;
+			*) "${f}" "message ${i}, long enough to fill the buffers";;
+		esac
+		i=$(( i + 1 ))
+	done
+done
+exit 0
+EOF
+
+# Start the shell on a pty, never read it, and give it 20 seconds
+cat > "${tmp}/onpty.py" <<'EOF'
+import os, pty, sys, time
+
+pid, fd = pty.fork()
+if pid == 0:
+    os.execvp(sys.argv[1], sys.argv[1:])
+deadline = time.time() + 20
+while time.time() < deadline:
+    p, status = os.waitpid(pid, os.WNOHANG)
+    if p:
+        sys.exit(0 if os.WIFEXITED(status) and os.WEXITSTATUS(status) == 0 else 1)
+    time.sleep(0.1)
+os.kill(pid, 9)
+os.waitpid(pid, 0)
+sys.exit(1)
+EOF
+
+# run <name> <shell> <functions.sh> <libexecdir> <stderr>
+run()
+{
+	# Keeps the FIFO from blocking the script's open, and is never read
+	[ "$5" = fifo ] && { rm -f "${tmp}/err" ; mkfifo "${tmp}/err" ; \
+		exec 3<>"${tmp}/err" ; }
+	if FUNCTIONS="$3" GENTOO_FUNCTIONS_LIBEXECDIR="$4" EINFO_NONBLOCK=yes \
+		EINFO_NONBLOCK_DIR="${tmp}/run" FIFO="${tmp}/err" TERM=dumb \
+		python3 "${tmp}/onpty.py" $2 "${tmp}/run.sh" "$5" ; then
+		printf '%s, stderr on the %s: does not block\n' "$1" "$5"
+	else
+		printf '%s, stderr on the %s: blocked\n' "$1" "$5"
+		ret=1
+	fi
+	[ "$5" = fifo ] && exec 3<&-
+}
+
+ret=0
+for sh in dash bash; do
+	command -v "${sh}" >/dev/null 2>&1 || continue
+	for err in pty fifo; do
+		run "generic-${sh}" "${sh}" "${tmp}/generic/functions.sh" \
+			"${tmp}/generic" "${err}"
+	done
+done
+for v in ${VARIANTS}; do
+	command -v "${v}" >/dev/null 2>&1 || continue
+	for err in pty fifo; do
+		run "${v}" "${v}" "${PWD}/${v}/functions.sh" "${PWD}" "${err}"
+	done
+done
+exit ${ret}
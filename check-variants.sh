@@ -0,0 +1,97 @@
+#!/bin/sh
+# Copyright 2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Run the e-functions with the generic functions.sh under every shell
+# at hand, and with each generated variant under its own shell, and
+# compare what they print, their NDJSON records and EINFO_LOGFILE.
+# Run by make check, from the top of a built tree.
+#
+
+VARIANTS="$*"
+tmp="${TMPDIR:-/tmp}/check-variants.$$"
+trap 'rm -rf "${tmp}"' EXIT
+mkdir -p "${tmp}/generic" || exit 1
+
+# Without a bash/ next to it functions.sh stays generic under bash too
+ln -s "${PWD}/functions.sh" "${PWD}/functions" "${tmp}/generic/"
+
+cat > "${tmp}/run.sh" <<'EOF'
+. "${FUNCTIONS}"
+EINFO_JSON_FD=3
+EINFO_LOGFILE="${LOGFILE}"
+EINFO_VERBOSE=yes
+
+einfo "hello 50%% \"quoted\" back\\slash	tab"
+einfo "control $(printf '\001\002\037\033\177') characters"
+einfon "no newline"
+einfo " and the rest"
+eindent 11
+ebegin "Doing ${GOOD}coloured${NORMAL} things"
+ewarn "a warning"
+eend 1 "it broke"
+eoutdent 4
+ebegin "next"
+eend
+veinfo "verbose"
+ewend 2 "warned"
+eerror "an error"
+eoutdent
+printf 'line one\nline two\n' | einfo_stream
+printf 'warn one\nwarn two\n' | ewarn_stream -
+RC_ENDCOL=no
+ebegin "no endcol"
+eend 0
+eboard_start
+eboard_set a "a job with a name much too long to fit on the line it is shown on, which has to be cut"
+eboard_set b "b job"
+eboard_draw -f
+eboard_del a
+eboard_set b "b job again"
+eboard_draw -f
+eboard_stop
+EOF
+
+# run <name> <shell> <functions.sh> <libexecdir>
+run()
+{
+	FUNCTIONS="$3" LOGFILE="${tmp}/$1.log" COLUMNS=80 TERM=dumb \
+		GENTOO_FUNCTIONS_LIBEXECDIR="$4" $2 "${tmp}/run.sh" \
+		> "${tmp}/$1.out" 2>&1 3> "${tmp}/$1.json"
+	# Times differ from run to run
+	sed -e 's/"time":[0-9null]*//' -e 's/"elapsed":[0-9]*//' \
+		"${tmp}/$1.json" > "${tmp}/$1.ndjson"
+	sed -e 's/^\[[ 0-9.]*\] //' "${tmp}/$1.log" > "${tmp}/$1.plain"
+}
+
+ret=0
+ref=
+for sh in dash bash "busybox ash" mksh; do
+	command -v "${sh%% *}" >/dev/null 2>&1 || continue
+	name="generic-${sh##* }"
+	run "${name}" "${sh}" "${tmp}/generic/functions.sh" "${tmp}/generic"
+	: "${ref:=${name}}"
+done
+for v in ${VARIANTS}; do
+	sh="${v}"
+	[ "${v}" = ash ] && sh="busybox ash"
+	command -v "${sh%% *}" >/dev/null 2>&1 || continue
+	run "${v}" "${sh}" "${PWD}/${v}/functions.sh" "${PWD}"
+done
+
+for f in "${tmp}"/*.out; do
+	name="${f##*/}"
+	name="${name%.out}"
+	[ "${name}" = "${ref}" ] && continue
+	same=yes
+	for ext in out ndjson plain; do
+		cmp -s "${tmp}/${ref}.${ext}" "${tmp}/${name}.${ext}" && continue
+		printf '%s differs from %s:\n' "${name}" "${ref}"
+		diff -u "${tmp}/${ref}.${ext}" "${tmp}/${name}.${ext}"
+		same=no
+		ret=1
+	done
+	[ "${same}" = no ] || printf '%s: same as %s\n' "${name}" "${ref}"
+done
+exit ${ret}
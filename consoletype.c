@@ -1,7 +1,8 @@
 /*
  * consoletype.c
  * simple app to figure out whether the current terminal
- * is serial, console (vt), or remote (pty).
+ * is serial, console (vt), or remote (pty). In status mode hvc, USB
+ * serial and other virtual consoles are told apart from serial.
  *
  * Copyright 1999-2020 Gentoo Authors
  * Distributed under the terms of the GNU General Public License v2
@@ -21,7 +22,11 @@ enum termtype {
 	IS_VT = 0,
 	IS_SERIAL = 1,
 	IS_PTY = 2,
-	IS_UNK = 3
+	IS_UNK = 3,
+	/* Only told apart in status mode, serial otherwise */
+	IS_HVC = 4,
+	IS_USB = 5,
+	IS_VIRTUAL = 6
 };
 
 const char * const tty_names[] = {
@@ -41,7 +46,14 @@ static inline int check_ttyname(void)
 	if (strncmp(tty, "/dev/", 5) == 0)
 		tty += 5;
 
-	if (!strncmp (tty, "ttyS", 4) || !strncmp (tty, "cuaa", 4))
+	if (!strncmp (tty, "hvc", 3) || !strncmp (tty, "hvsi", 4))
+		return IS_HVC;
+	else if (!strncmp (tty, "ttyUSB", 6) || !strncmp (tty, "ttyACM", 6))
+		return IS_USB;
+	else if (!strncmp (tty, "xvc", 3) || !strncmp (tty, "ttysclp", 7) ||
+	    !strncmp (tty, "sclp_line", 9) || !strncmp (tty, "3270/", 5))
+		return IS_VIRTUAL;
+	else if (!strncmp (tty, "ttyS", 4) || !strncmp (tty, "cuaa", 4))
 		return IS_SERIAL;
 	else if (!strncmp (tty, "pts/", 4) || !strncmp (tty, "ttyp", 4))
 		return IS_PTY;
@@ -59,6 +71,10 @@ static inline int check_devnode(void)
 
 	fstat(0, &sb);
 	maj = major(sb.st_rdev);
+	if (maj == 229)
+		return IS_HVC;
+	if (maj == 166 || maj == 188)
+		return IS_USB;
 	if (maj != 3 && (maj < 136 || maj > 143)) {
 #if defined(TIOCLINUX)
 		unsigned char twelve = 12;
@@ -78,6 +94,13 @@ int main(int argc, char *argv[])
 	int type = check_ttyname();
 	if (type == IS_UNK)
 		type = check_devnode();
+
+	/* Just the exit code, so that no one has to read our output */
+	if (argc > 1 && strcmp(argv[1], "status") == 0)
+		return type;
+
+	if (type > IS_UNK)
+		type = IS_SERIAL;
 	puts(tty_names[type]);
 	if (argc > 1 && strcmp(argv[1], "stdout") == 0)
 		rc = 0;
@@ -0,0 +1,258 @@
+/*
+ * econsole.c
+ * helper for the EINFO_NONBLOCK mode of functions.sh: copies what the
+ * e-functions write into a FIFO to the console, without ever making
+ * them wait for it. What the console cannot take yet is kept in a
+ * bounded backlog. Lines that do not fit are dropped and counted, and
+ * a "N messages suppressed" line is shown in their place.
+ *
+ * The helper stops when everybody has closed the FIFO, or when the
+ * script given by -p is gone, and gives the console the few seconds
+ * of -t to take what is left.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "fifo.h"
+
+static char *backlog;
+static size_t size, head, len;
+
+static int console;
+static int dead;		/* the console is gone, discard everything */
+static int dropping;		/* the rest of this line is dropped */
+static int at_bol = 1;		/* the last byte kept ended a line */
+static unsigned long suppressed;
+
+static void keep(const char *p, size_t n)
+{
+	size_t tail = (head + len) % size, part = size - tail;
+
+	if (part > n)
+		part = n;
+	memcpy(backlog + tail, p, part);
+	memcpy(backlog, p + part, n - part);
+	len += n;
+}
+
+/* queue the suppressed marker if there is room for it and n more */
+static int mark(size_t n)
+{
+	char buf[64];
+	int m;
+
+	if (suppressed == 0)
+		return 1;
+	m = snprintf(buf, sizeof(buf), "%s * %lu messages suppressed\n",
+		     at_bol ? "" : "\n", suppressed);
+	if (m + n > size - len)
+		return 0;
+	keep(buf, m);
+	suppressed = 0;
+	at_bol = 1;
+	return 1;
+}
+
+/* queue one line, or the start of one, if it fits */
+static void take(const char *p, size_t n)
+{
+	int eol = p[n - 1] == '\n';
+
+	if (dead)
+		return;
+	if (dropping) {
+		if (eol) {
+			dropping = 0;
+			suppressed++;
+		}
+		return;
+	}
+
+	if (n > size - len || !mark(n)) {
+		if (eol)
+			suppressed++;
+		else
+			dropping = 1;
+		return;
+	}
+	keep(p, n);
+	at_bol = eol;
+}
+
+static void flush(void)
+{
+	size_t part = size - head;
+	ssize_t n;
+
+	if (part > len)
+		part = len;
+	n = write(console, backlog + head, part);
+	if (n < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return;
+		/* EIO, EPIPE, ...: nobody will read it */
+		dead = 1;
+		len = 0;
+		return;
+	}
+	head = (head + n) % size;
+	len -= n;
+}
+
+/* read what the script wrote, return 0 at the end and -1 if none yet */
+static int readin(int in)
+{
+	char buf[4096], *p, *nl;
+	ssize_t n;
+
+	n = read(in, buf, sizeof(buf));
+	if (n < 0 && (errno == EINTR || errno == EAGAIN))
+		return -1;
+	if (n <= 0)
+		return 0;
+	for (p = buf; p < buf + n; p = nl) {
+		nl = memchr(p, '\n', buf + n - p);
+		nl = nl ? nl + 1 : buf + n;
+		take(p, nl - p);
+	}
+	return 1;
+}
+
+static long now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int main(int argc, char *argv[])
+{
+	struct pollfd fds[3];
+	struct stat st;
+	long deadline = 0, drain = 10;
+	int opt, in, nfds, timeout, w = -1, script = -1, r;
+	pid_t pid = 0;
+
+	size = 65536;
+	while ((opt = getopt(argc, argv, "b:p:t:w:")) != -1) {
+		switch (opt) {
+		case 'b':
+			size = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			pid = strtol(optarg, NULL, 10);
+			break;
+		case 't':
+			drain = strtol(optarg, NULL, 0);
+			break;
+		case 'w':
+			w = strtol(optarg, NULL, 10);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || size < 128)
+		goto usage;
+	backlog = malloc(size);
+	if (backlog == NULL)
+		return 1;
+
+	/* Files never block, and a file opened anew would not share the offset */
+	if (fstat(STDOUT_FILENO, &st) == 0 && S_ISREG(st.st_mode))
+		return 1;
+
+	in = fifo_open(argv[optind], w);
+	if (in < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	/*
+	 * Open the console anew, so that O_NONBLOCK does not leak to the
+	 * script, which shares our stdout. Without that the script keeps
+	 * writing to the console itself.
+	 */
+	console = open("/proc/self/fd/1", O_WRONLY | O_NONBLOCK | O_NOCTTY |
+		       O_CLOEXEC);
+	if (console < 0) {
+		perror("econsole: /proc/self/fd/1");
+		return 1;
+	}
+	script = fifo_watch(pid);
+	signal(SIGPIPE, SIG_IGN);
+	/* Keep showing what is left when the script is interrupted */
+	signal(SIGINT, SIG_IGN);
+	fifo_detach();
+
+	for (;;) {
+		if (in < 0 && !dead)
+			mark(0);
+		nfds = 0;
+		if (in >= 0) {
+			fds[nfds].fd = in;
+			fds[nfds++].events = POLLIN;
+		}
+		if (in >= 0 && script >= 0) {
+			fds[nfds].fd = script;
+			fds[nfds++].events = POLLIN;
+		}
+		if (len > 0) {
+			fds[nfds].fd = console;
+			fds[nfds++].events = POLLOUT;
+		}
+		if (nfds == 0)
+			break;
+
+		/* Once the script is done, give the console a little more */
+		timeout = -1;
+		if (in < 0) {
+			timeout = deadline - now();
+			if (timeout <= 0)
+				break;
+		}
+		if (poll(fds, nfds, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		r = 1;
+		if (in >= 0 && fds[0].revents)
+			r = readin(in);
+		/* The script is gone, take what it left and stop reading */
+		if (in >= 0 && script >= 0 && fds[1].revents) {
+			while ((r = readin(in)) > 0)
+				;
+			r = 0;
+		}
+		if (r == 0) {
+			close(in);
+			in = -1;
+			deadline = now() + drain * 1000;
+			continue;
+		}
+		if (len > 0)
+			flush();
+	}
+	return 0;
+
+usage:
+	fprintf(stderr, "Usage: %s [-b bytes] [-p pid] [-t seconds] [-w fd] <fifo>\n",
+		argv[0]);
+	return 2;
+}
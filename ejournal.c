@@ -0,0 +1,353 @@
+/*
+ * ejournal.c
+ * helper for the EINFO_JOURNAL mode of functions.sh: reads the
+ * records esyslog writes into a FIFO and sends them to the journal in
+ * its native protocol, with their fields intact. Records that arrive
+ * together go out in one sendmmsg call; messages too big for a
+ * datagram are passed in a sealed memfd.
+ *
+ * A record is one line of tab separated fields: priority (as for
+ * logger -p), identifier, pid, script, function, indentation and the
+ * message, escaped as in a JSON string. Lines with fewer fields are
+ * skipped.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "fifo.h"
+
+#define BATCH_MAX	64
+#define NFIELDS		7
+
+struct dgram {
+	char *data;
+	size_t len, size;
+};
+
+static const char *const levels[] = {
+	"emerg", "alert", "crit", "err", "warning", "notice", "info", "debug"
+};
+
+static const struct {
+	const char *name;
+	int code;
+} facilities[] = {
+	{ "kern", 0 }, { "user", 1 }, { "mail", 2 }, { "daemon", 3 },
+	{ "auth", 4 }, { "syslog", 5 }, { "lpr", 6 }, { "news", 7 },
+	{ "uucp", 8 }, { "cron", 9 }, { "authpriv", 10 }, { "ftp", 11 },
+	{ "local0", 16 }, { "local1", 17 }, { "local2", 18 }, { "local3", 19 },
+	{ "local4", 20 }, { "local5", 21 }, { "local6", 22 }, { "local7", 23 },
+};
+
+static struct sockaddr_un addr;
+static int sock = -1;
+
+static struct dgram batch[BATCH_MAX];
+static int nbatch;
+
+/* "daemon.warning", as taken by logger -p, into numbers */
+static void parse_priority(const char *s, int *facility, int *level)
+{
+	const char *dot = strchr(s, '.'), *lvl = dot ? dot + 1 : s;
+	size_t i;
+
+	*facility = 1;
+	*level = 5;
+	if (dot)
+		for (i = 0; i < sizeof(facilities) / sizeof(facilities[0]); i++)
+			if (strlen(facilities[i].name) == (size_t)(dot - s) &&
+			    strncasecmp(s, facilities[i].name, dot - s) == 0)
+				*facility = facilities[i].code;
+	if (strcasecmp(lvl, "error") == 0)
+		lvl = "err";
+	else if (strcasecmp(lvl, "warn") == 0)
+		lvl = "warning";
+	for (i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+		if (strcasecmp(lvl, levels[i]) == 0)
+			*level = i;
+}
+
+/* undo _ejson_escape in place, return the new length */
+static size_t unescape(char *s)
+{
+	char *r = s, *w = s;
+	unsigned c;
+
+	while (*r) {
+		if (*r != '\\' || r[1] == '\0') {
+			*w++ = *r++;
+			continue;
+		}
+		r++;
+		switch (*r) {
+		case 'n': *w++ = '\n'; break;
+		case 't': *w++ = '\t'; break;
+		case 'r': *w++ = '\r'; break;
+		case 'u':
+			if (sscanf(r + 1, "%4x", &c) == 1 && c < 0x80) {
+				*w++ = c;
+				r += 4;
+				break;
+			}
+			/* fall through */
+		default: *w++ = *r; break;
+		}
+		r++;
+	}
+	*w = '\0';
+	return w - s;
+}
+
+static void add(struct dgram *d, const void *p, size_t n)
+{
+	char *data;
+
+	if (d->len + n > d->size) {
+		d->size = (d->len + n) * 2 + 256;
+		data = realloc(d->data, d->size);
+		if (data == NULL)
+			abort();
+		d->data = data;
+	}
+	memcpy(d->data + d->len, p, n);
+	d->len += n;
+}
+
+/* one field, in the binary form if the value has a newline */
+static void field(struct dgram *d, const char *name, const char *value,
+		  size_t len)
+{
+	uint64_t le = len;
+	unsigned char size[8];
+	int i;
+
+	add(d, name, strlen(name));
+	if (memchr(value, '\n', len) == NULL) {
+		add(d, "=", 1);
+		add(d, value, len);
+	} else {
+		for (i = 0; i < 8; i++)
+			size[i] = le >> (8 * i);
+		add(d, "\n", 1);
+		add(d, size, 8);
+		add(d, value, len);
+	}
+	add(d, "\n", 1);
+}
+
+static void build(struct dgram *d, char *line)
+{
+	char *f[NFIELDS], num[16];
+	int i, facility, level;
+
+	d->len = 0;
+	for (i = 0; i < NFIELDS - 1; i++) {
+		f[i] = line;
+		line = strchr(line, '\t');
+		if (line == NULL)
+			return;
+		*line++ = '\0';
+	}
+	f[i] = line;
+
+	parse_priority(f[0], &facility, &level);
+	snprintf(num, sizeof(num), "%d", level);
+	field(d, "PRIORITY", num, strlen(num));
+	snprintf(num, sizeof(num), "%d", facility);
+	field(d, "SYSLOG_FACILITY", num, strlen(num));
+	field(d, "SYSLOG_IDENTIFIER", f[1], strlen(f[1]));
+	field(d, "SYSLOG_PID", f[2], strlen(f[2]));
+	field(d, "CODE_FILE", f[3], strlen(f[3]));
+	field(d, "CODE_FUNC", f[4], strlen(f[4]));
+	field(d, "EINFO_INDENT", f[5], strlen(f[5]));
+	field(d, "MESSAGE", f[6], unescape(f[6]));
+}
+
+static int reconnect(void)
+{
+	if (sock >= 0)
+		return 0;
+	sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+	if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		close(sock);
+		sock = -1;
+		return -1;
+	}
+	return 0;
+}
+
+/* too big for a datagram: hand the journal a sealed memfd instead */
+static void send_memfd(const struct dgram *d)
+{
+	char control[CMSG_SPACE(sizeof(int))];
+	struct msghdr mh = { 0 };
+	struct cmsghdr *cm;
+	int fd;
+
+	fd = memfd_create("ejournal", MFD_ALLOW_SEALING | MFD_CLOEXEC);
+	if (fd < 0)
+		return;
+	if (write(fd, d->data, d->len) != (ssize_t)d->len ||
+	    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+		  F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+		close(fd);
+		return;
+	}
+
+	memset(control, 0, sizeof(control));
+	mh.msg_control = control;
+	mh.msg_controllen = sizeof(control);
+	cm = CMSG_FIRSTHDR(&mh);
+	cm->cmsg_level = SOL_SOCKET;
+	cm->cmsg_type = SCM_RIGHTS;
+	cm->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+	sendmsg(sock, &mh, MSG_NOSIGNAL);
+	close(fd);
+}
+
+static void send_batch(void)
+{
+	struct mmsghdr msgs[BATCH_MAX];
+	struct iovec iov[BATCH_MAX];
+	int i, sent;
+
+	if (nbatch == 0)
+		return;
+	/* Without a journal the records are dropped, as logger would */
+	if (reconnect() < 0) {
+		nbatch = 0;
+		return;
+	}
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < nbatch; i++) {
+		iov[i].iov_base = batch[i].data;
+		iov[i].iov_len = batch[i].len;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	for (i = 0; i < nbatch; ) {
+		sent = sendmmsg(sock, msgs + i, nbatch - i, MSG_NOSIGNAL);
+		if (sent > 0) {
+			i += sent;
+			continue;
+		}
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent < 0 && (errno == EMSGSIZE || errno == ENOBUFS))
+			send_memfd(&batch[i]);
+		else if (sent < 0 && errno != EAGAIN) {
+			/* The journal went away, try again next time */
+			close(sock);
+			sock = -1;
+			break;
+		}
+		i++;
+	}
+	nbatch = 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *path = "/run/systemd/journal/socket";
+	char *buf = NULL, *line, *nl;
+	size_t size = 0, len = 0;
+	ssize_t n;
+	struct pollfd fds[2];
+	int opt, in, w = -1, script, gone = 0;
+	pid_t pid = 0;
+
+	while ((opt = getopt(argc, argv, "p:s:w:")) != -1) {
+		switch (opt) {
+		case 'p':
+			pid = strtol(optarg, NULL, 10);
+			break;
+		case 's':
+			path = optarg;
+			break;
+		case 'w':
+			w = strtol(optarg, NULL, 10);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || strlen(path) >= sizeof(addr.sun_path))
+		goto usage;
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	in = fifo_open(argv[optind], w);
+	if (in < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+	script = fifo_watch(pid);
+	fifo_detach();
+
+	fds[0].fd = in;
+	fds[0].events = POLLIN;
+	fds[1].fd = script;
+	fds[1].events = POLLIN;
+	for (;;) {
+		if (size - len < 65536) {
+			size = size * 2 + 65536;
+			buf = realloc(buf, size);
+			if (buf == NULL)
+				return 1;
+		}
+		/* Once the script is gone, take what it left and stop */
+		if (!gone && poll(fds, script >= 0 ? 2 : 1, -1) < 0 &&
+		    errno != EINTR)
+			break;
+		if (script >= 0 && fds[1].revents)
+			gone = 1;
+		n = read(in, buf + len, size - len - 1);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && errno == EAGAIN && !gone)
+			continue;
+		if (n <= 0)
+			break;
+		len += n;
+		buf[len] = '\0';
+
+		/* Everything read in one go is sent in one go */
+		line = buf;
+		while ((nl = memchr(line, '\n', buf + len - line)) != NULL) {
+			*nl = '\0';
+			build(&batch[nbatch], line);
+			if (batch[nbatch].len > 0 && ++nbatch == BATCH_MAX)
+				send_batch();
+			line = nl + 1;
+		}
+		send_batch();
+		len -= line - buf;
+		memmove(buf, line, len);
+	}
+	return 0;
+
+usage:
+	fprintf(stderr, "Usage: %s [-p pid] [-s socket] [-w fd] <fifo>\n",
+		argv[0]);
+	return 2;
+}
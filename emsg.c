@@ -0,0 +1,672 @@
+/*
+ * emsg.c
+ * e-messages for C programs, see emsg.h.
+ *
+ * Callers never take a lock: each message is copied into a slot of a
+ * bounded ring (Dmitry Vyukov's MPMC design, with a single consumer)
+ * and a writer thread formats the queued messages and writes them out
+ * in batches, one write per run of messages to the same stream. The
+ * writer only sleeps when the ring is empty, so busy callers do not
+ * have to wake it.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "emsg.h"
+
+#define QUEUE_SIZE	256	/* slots in the ring, a power of two */
+#define TEXT_MAX	1024	/* longer messages are cut */
+#define BATCH_MAX	64	/* records written per batch at most */
+#define DEPTH_MAX	32	/* nested ebegins tracked per thread */
+#define OUT_MAX		(16 * 1024)
+#define DEFAULT_INDENT	2
+
+enum kind { INFO, WARN, ERROR, BEGIN, END };
+
+enum state { IDLE, RUNNING, STOPPING, DIRECT };
+
+struct record {
+	unsigned char kind;
+	unsigned char newline;
+	int retval;
+	int indent;
+	unsigned thread;
+	unsigned long span;
+	char text[TEXT_MAX];
+};
+
+struct cell {
+	atomic_size_t seq;
+	struct record rec;
+};
+
+/* an ebegin waiting for its eend, kept by the writer */
+struct span {
+	unsigned long id;
+	int indent;
+	char *text;
+};
+
+static struct cell queue[QUEUE_SIZE];
+static atomic_size_t tail;		/* next slot callers claim */
+static size_t head;			/* next slot the writer reads */
+
+static atomic_int state;
+static atomic_int sleeping;
+static size_t done;			/* head after the last batch */
+static pthread_t writer_thread;
+static pthread_mutex_t start_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t direct_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wakeup = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t drained = PTHREAD_COND_INITIALIZER;
+
+static atomic_uint next_thread;
+static atomic_ulong next_span;
+static __thread unsigned thread_id;
+static __thread int thread_indent;
+static __thread int thread_depth;
+static __thread unsigned long thread_spans[DEPTH_MAX];
+
+/* The rest is only used by whoever drains the ring */
+static const char *ident;
+static int flags;
+static int quiet, equiet, endcol, cols;
+static const char *good = "", *warn = "", *bad = "";
+static const char *bracket = "", *normal = "";
+
+static char out[OUT_MAX];
+static size_t outlen;
+static int outfd = STDOUT_FILENO;
+
+static unsigned last_thread;		/* who wrote the last line */
+static unsigned long open_span;		/* ebegin line still open */
+static int last_len;
+
+static struct span *spans;
+static size_t nspans, maxspans;
+
+/* the same test as yesno in functions.sh */
+static int env_yes(const char *name, int dflt)
+{
+	const char *v = getenv(name);
+
+	if (v == NULL || *v == '\0')
+		return dflt;
+	return strcasecmp(v, "yes") == 0 || strcasecmp(v, "true") == 0 ||
+	       strcasecmp(v, "on") == 0 || strcmp(v, "1") == 0;
+}
+
+static void setup(void)
+{
+	const char *v = getenv("CONSOLETYPE");
+	int serial = v && strcmp(v, "serial") == 0;
+
+	quiet = env_yes("EINFO_QUIET", 0);
+	equiet = env_yes("EERROR_QUIET", 0);
+	endcol = !serial && env_yes("RC_ENDCOL", 1);
+	if (!serial && !env_yes("RC_NOCOLOR", 0)) {
+		good = "\033[32;01m";
+		warn = "\033[33;01m";
+		bad = "\033[31;01m";
+		bracket = "\033[34;01m";
+		normal = "\033[0m";
+	}
+
+	v = getenv("EINFO_LOG");
+	if (v && *v)
+		flags |= EMSG_SYSLOG;
+	if (flags & EMSG_SYSLOG)
+		openlog(ident ? ident : program_invocation_short_name, 0,
+			LOG_DAEMON);
+}
+
+/* follow the terminal size, as RC_TRACK_WINCH does */
+static void update_cols(void)
+{
+	struct winsize ws;
+	const char *v;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+		cols = ws.ws_col;
+		return;
+	}
+	if (cols > 0)
+		return;
+	v = getenv("COLUMNS");
+	cols = v ? atoi(v) : 0;
+	if (cols <= 0)
+		cols = 80;
+}
+
+static void flush_out(void)
+{
+	size_t off = 0;
+	ssize_t n;
+
+	while (off < outlen) {
+		n = write(outfd, out + off, outlen - off);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		off += n;
+	}
+	outlen = 0;
+}
+
+static void put(int fd, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (fd != outfd) {
+		flush_out();
+		outfd = fd;
+	}
+	for (;;) {
+		va_start(ap, fmt);
+		n = vsnprintf(out + outlen, OUT_MAX - outlen, fmt, ap);
+		va_end(ap);
+		if (n < 0)
+			return;
+		if ((size_t)n < OUT_MAX - outlen) {
+			outlen += n;
+			return;
+		}
+		if (outlen == 0) {
+			outlen = OUT_MAX - 1;
+			return;
+		}
+		flush_out();
+	}
+}
+
+/* end an ebegin line left open without ENDCOL, like LAST_E_CMD does */
+static void close_line(int fd)
+{
+	if (open_span == 0)
+		return;
+	put(fd, "\n");
+	open_span = 0;
+}
+
+static void span_open(const struct record *rec)
+{
+	struct span *s;
+
+	if (nspans == maxspans) {
+		s = realloc(spans, (maxspans + 16) * sizeof(*s));
+		if (s == NULL)
+			return;
+		spans = s;
+		maxspans += 16;
+	}
+	s = &spans[nspans];
+	s->text = strdup(rec->text);
+	if (s->text == NULL)
+		return;
+	s->id = rec->span;
+	s->indent = rec->indent;
+	nspans++;
+}
+
+static struct span span_close(unsigned long id)
+{
+	struct span s = { 0, 0, NULL };
+	size_t i;
+
+	for (i = nspans; id && i-- > 0; ) {
+		if (spans[i].id != id)
+			continue;
+		s = spans[i];
+		spans[i] = spans[--nspans];
+		break;
+	}
+	return s;
+}
+
+static void message(int fd, const char *colour, const struct record *rec)
+{
+	close_line(fd);
+	put(fd, " %s*%s %*s%s%s", colour, normal, rec->indent, "",
+	    rec->text, rec->newline ? "\n" : "");
+	last_thread = rec->thread;
+}
+
+static void begin(const struct record *rec)
+{
+	span_open(rec);
+	if (quiet)
+		return;
+	close_line(STDOUT_FILENO);
+	put(STDOUT_FILENO, " %s*%s %*s%s ...", good, normal, rec->indent, "",
+	    rec->text);
+	if (endcol)
+		put(STDOUT_FILENO, "\n");
+	else {
+		open_span = rec->span;
+		last_len = 3 + rec->indent + (int)strlen(rec->text) + 4;
+	}
+	last_thread = rec->thread;
+}
+
+/*
+ * The status goes at the end of the last line if this thread wrote it,
+ * as eend does. Otherwise another thread wrote in between, and the
+ * ebegin line is shown again with the status.
+ */
+static void end(const struct record *rec)
+{
+	struct span s = span_close(rec->span);
+	const char *text = s.text ? s.text : "";
+	const char *colour = rec->retval == 0 ? good : bad;
+	const char *status = rec->retval == 0 ? "ok" : "!!";
+	int pad;
+
+	if (rec->retval == 0 && quiet)
+		goto out;
+
+	if (endcol) {
+		if (last_thread != rec->thread)
+			put(STDOUT_FILENO, " %s*%s %*s%s ...\n", good, normal,
+			    s.indent, "", text);
+		put(STDOUT_FILENO, "\033[A\033[%dC  ", cols - 8);
+	} else {
+		if (open_span && open_span == rec->span)
+			pad = cols - last_len - 6;
+		else {
+			close_line(STDOUT_FILENO);
+			if (last_thread == rec->thread)
+				pad = cols - 6;
+			else {
+				put(STDOUT_FILENO, " %s*%s %*s%s ...", good, normal,
+				    s.indent, "", text);
+				pad = cols - 3 - s.indent - (int)strlen(text) - 4 - 6;
+			}
+		}
+		put(STDOUT_FILENO, "%*s", pad > 0 ? pad : 0, "");
+		open_span = 0;
+	}
+	put(STDOUT_FILENO, "%s[ %s%s%s ]%s\n", bracket, colour, status,
+	    bracket, normal);
+	last_thread = rec->thread;
+out:
+	free(s.text);
+}
+
+/* errors are logged as "rc-scripts", as eerror does */
+static void log_error(const char *text)
+{
+	openlog("rc-scripts", 0, LOG_DAEMON);
+	syslog(LOG_DAEMON | LOG_ERR, "%s", text);
+	openlog(ident ? ident : program_invocation_short_name, 0, LOG_DAEMON);
+}
+
+static void process(const struct record *rec)
+{
+	switch (rec->kind) {
+	case INFO:
+		if (!quiet)
+			message(STDOUT_FILENO, good, rec);
+		break;
+	case WARN:
+		if (quiet)
+			break;
+		message(STDERR_FILENO, warn, rec);
+		if (flags & EMSG_SYSLOG)
+			syslog(LOG_DAEMON | LOG_WARNING, "%s", rec->text);
+		break;
+	case ERROR:
+		if (equiet)
+			break;
+		message(STDERR_FILENO, bad, rec);
+		if (flags & EMSG_SYSLOG)
+			log_error(rec->text);
+		break;
+	case BEGIN:
+		begin(rec);
+		break;
+	case END:
+		end(rec);
+		break;
+	}
+}
+
+static struct cell *ready(void)
+{
+	struct cell *c = &queue[head & (QUEUE_SIZE - 1)];
+
+	if (atomic_load(&c->seq) != head + 1)
+		return NULL;
+	return c;
+}
+
+static void release(struct cell *c)
+{
+	atomic_store_explicit(&c->seq, head + QUEUE_SIZE, memory_order_release);
+	head++;
+}
+
+/* write up to max ready records, return how many */
+static int drain(int max)
+{
+	struct cell *c;
+	int n = 0;
+
+	update_cols();
+	while (n < max && (c = ready()) != NULL) {
+		process(&c->rec);
+		release(c);
+		n++;
+	}
+	flush_out();
+	return n;
+}
+
+/* write everything claimed so far, waiting for slots still being filled */
+static void drain_all(void)
+{
+	while (head != atomic_load(&tail)) {
+		if (ready() == NULL)
+			sched_yield();
+		else
+			drain(BATCH_MAX);
+	}
+}
+
+static void *writer(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		if (drain(BATCH_MAX) > 0) {
+			pthread_mutex_lock(&wait_lock);
+			done = head;
+			pthread_cond_broadcast(&drained);
+			pthread_mutex_unlock(&wait_lock);
+			continue;
+		}
+
+		/* Pairs with the check in publish(): either the caller sees
+		 * us sleeping, or we see its record */
+		pthread_mutex_lock(&wait_lock);
+		atomic_store(&sleeping, 1);
+		while (ready() == NULL && atomic_load(&state) == RUNNING)
+			pthread_cond_wait(&wakeup, &wait_lock);
+		atomic_store(&sleeping, 0);
+		pthread_mutex_unlock(&wait_lock);
+
+		if (ready() == NULL && atomic_load(&state) != RUNNING)
+			break;
+	}
+	return NULL;
+}
+
+static void wake_writer(void)
+{
+	pthread_mutex_lock(&wait_lock);
+	pthread_cond_signal(&wakeup);
+	pthread_mutex_unlock(&wait_lock);
+}
+
+static void after_fork(void)
+{
+	size_t i;
+
+	/* The writer did not come along, start over in the child */
+	if (atomic_load(&state) == RUNNING || atomic_load(&state) == STOPPING) {
+		for (i = 0; i < QUEUE_SIZE; i++)
+			atomic_init(&queue[i].seq, i);
+		atomic_init(&tail, 0);
+		head = done = 0;
+		atomic_init(&sleeping, 0);
+		atomic_init(&state, IDLE);
+	}
+	pthread_mutex_init(&start_lock, NULL);
+	pthread_mutex_init(&wait_lock, NULL);
+	pthread_mutex_init(&direct_lock, NULL);
+	pthread_cond_init(&wakeup, NULL);
+	pthread_cond_init(&drained, NULL);
+}
+
+/* first use, with start_lock held */
+static void prepare(void)
+{
+	static int once;
+	size_t i;
+
+	if (once)
+		return;
+	once = 1;
+	for (i = 0; i < QUEUE_SIZE; i++)
+		atomic_init(&queue[i].seq, i);
+	setup();
+	pthread_atfork(NULL, NULL, after_fork);
+	atexit(emsg_shutdown);
+}
+
+static void start(void)
+{
+	pthread_mutex_lock(&start_lock);
+	if (atomic_load(&state) == IDLE) {
+		prepare();
+		/* Before the writer runs, or it would stop right away */
+		atomic_store(&state, RUNNING);
+		if (pthread_create(&writer_thread, NULL, writer, NULL) != 0)
+			atomic_store(&state, DIRECT);
+	}
+	pthread_mutex_unlock(&start_lock);
+}
+
+static struct cell *claim(size_t *posp)
+{
+	size_t pos = atomic_load_explicit(&tail, memory_order_relaxed);
+	struct cell *c;
+	intptr_t dif;
+
+	for (;;) {
+		c = &queue[pos & (QUEUE_SIZE - 1)];
+		dif = (intptr_t)atomic_load_explicit(&c->seq,
+			memory_order_acquire) - (intptr_t)pos;
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak(&tail, &pos, pos + 1))
+				break;
+		} else if (dif < 0) {
+			/* The ring is full, let it drain */
+			if (atomic_load(&state) == DIRECT) {
+				pthread_mutex_lock(&direct_lock);
+				drain_all();
+				pthread_mutex_unlock(&direct_lock);
+			} else {
+				if (atomic_load(&sleeping))
+					wake_writer();
+				sched_yield();
+			}
+			pos = atomic_load_explicit(&tail, memory_order_relaxed);
+		} else
+			pos = atomic_load_explicit(&tail, memory_order_relaxed);
+	}
+	*posp = pos;
+	return c;
+}
+
+static void publish(struct cell *c, size_t pos)
+{
+	atomic_store(&c->seq, pos + 1);
+	if (atomic_load(&sleeping))
+		wake_writer();
+
+	/* No writer any more, write it ourselves */
+	if (atomic_load(&state) == DIRECT) {
+		pthread_mutex_lock(&direct_lock);
+		drain_all();
+		pthread_mutex_unlock(&direct_lock);
+	}
+}
+
+static void send(int kind, int newline, int retval, unsigned long span,
+		 const char *fmt, va_list ap)
+{
+	struct record *rec;
+	struct cell *c;
+	size_t pos;
+
+	if (thread_id == 0)
+		thread_id = atomic_fetch_add(&next_thread, 1) + 1;
+	if (atomic_load(&state) == IDLE)
+		start();
+
+	c = claim(&pos);
+	rec = &c->rec;
+	rec->kind = kind;
+	rec->newline = newline;
+	rec->retval = retval;
+	rec->indent = thread_indent;
+	rec->thread = thread_id;
+	rec->span = span;
+	if (fmt)
+		vsnprintf(rec->text, sizeof(rec->text), fmt, ap);
+	else
+		rec->text[0] = '\0';
+	publish(c, pos);
+}
+
+int emsg_init(const char *name, int mode)
+{
+	pthread_mutex_lock(&start_lock);
+	ident = name;
+	flags = mode;
+	pthread_mutex_unlock(&start_lock);
+	return 0;
+}
+
+#define EMSG_FUNC(name, kind, newline, ret) \
+int name(const char *fmt, ...) \
+{ \
+	va_list ap; \
+	va_start(ap, fmt); \
+	send(kind, newline, 0, 0, fmt, ap); \
+	va_end(ap); \
+	return ret; \
+}
+
+EMSG_FUNC(emsg_info, INFO, 1, 0)
+EMSG_FUNC(emsg_infon, INFO, 0, 0)
+EMSG_FUNC(emsg_warn, WARN, 1, 0)
+EMSG_FUNC(emsg_warnn, WARN, 0, 0)
+EMSG_FUNC(emsg_error, ERROR, 1, 1)
+EMSG_FUNC(emsg_errorn, ERROR, 0, 1)
+
+int emsg_begin(const char *fmt, ...)
+{
+	unsigned long span = atomic_fetch_add(&next_span, 1) + 1;
+	va_list ap;
+
+	if (thread_depth < DEPTH_MAX)
+		thread_spans[thread_depth] = span;
+	thread_depth++;
+
+	va_start(ap, fmt);
+	send(BEGIN, 0, 0, span, fmt, ap);
+	va_end(ap);
+	return 0;
+}
+
+static int do_end(int kind, int retval, const char *fmt, va_list ap)
+{
+	unsigned long span = 0;
+	va_list copy;
+
+	if (thread_depth > 0 && --thread_depth < DEPTH_MAX)
+		span = thread_spans[thread_depth];
+
+	if (retval != 0 && fmt && *fmt) {
+		va_copy(copy, ap);
+		send(kind, 1, 0, 0, fmt, copy);
+		va_end(copy);
+	}
+	send(END, 0, retval, span, NULL, ap);
+	return retval;
+}
+
+int emsg_end(int retval, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	do_end(ERROR, retval, fmt, ap);
+	va_end(ap);
+	return retval;
+}
+
+int emsg_wend(int retval, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	do_end(WARN, retval, fmt, ap);
+	va_end(ap);
+	return retval;
+}
+
+void emsg_indent(void)
+{
+	thread_indent += DEFAULT_INDENT;
+}
+
+void emsg_outdent(void)
+{
+	thread_indent -= DEFAULT_INDENT;
+	if (thread_indent < 0)
+		thread_indent = 0;
+}
+
+void emsg_flush(void)
+{
+	size_t target = atomic_load(&tail);
+
+	if (atomic_load(&state) != RUNNING)
+		return;
+	pthread_mutex_lock(&wait_lock);
+	pthread_cond_signal(&wakeup);
+	while (done < target && atomic_load(&state) == RUNNING)
+		pthread_cond_wait(&drained, &wait_lock);
+	pthread_mutex_unlock(&wait_lock);
+}
+
+void emsg_shutdown(void)
+{
+	pthread_mutex_lock(&start_lock);
+	prepare();
+	if (atomic_load(&state) == RUNNING) {
+		atomic_store(&state, STOPPING);
+		pthread_mutex_lock(&wait_lock);
+		pthread_cond_broadcast(&wakeup);
+		pthread_cond_broadcast(&drained);
+		pthread_mutex_unlock(&wait_lock);
+		pthread_join(writer_thread, NULL);
+	}
+	/* Pairs with the check in publish(): records claimed before this
+	 * are drained below, later ones by their callers */
+	atomic_store(&state, DIRECT);
+	pthread_mutex_lock(&direct_lock);
+	drain_all();
+	pthread_mutex_unlock(&direct_lock);
+	pthread_mutex_unlock(&start_lock);
+}
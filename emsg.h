@@ -0,0 +1,77 @@
+/*
+ * emsg.h
+ * e-messages for C programs: einfo, ewarn, eerror and ebegin/eend in
+ * the format functions.sh prints them, callable from any thread.
+ *
+ * Messages are queued and written by one writer thread, started on
+ * first use. Indentation and open ebegin spans are per thread, so each
+ * thread's eend finds its own ebegin.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#ifndef EMSG_H
+#define EMSG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define EMSG_PRINTF(f, a) __attribute__((format(printf, f, a)))
+#else
+#define EMSG_PRINTF(f, a)
+#endif
+
+/* Also log warnings and errors to syslog, as EINFO_LOG does */
+#define EMSG_SYSLOG	0x1
+
+/*
+ * Set the syslog identity and flags. Only has an effect before the
+ * first message; without it the program name is used. Errors are
+ * logged as "rc-scripts" either way.
+ */
+int emsg_init(const char *ident, int flags);
+
+/* Like einfo/einfon, return 0 */
+int emsg_info(const char *fmt, ...) EMSG_PRINTF(1, 2);
+int emsg_infon(const char *fmt, ...) EMSG_PRINTF(1, 2);
+
+/* Like ewarn/ewarnn, return 0 */
+int emsg_warn(const char *fmt, ...) EMSG_PRINTF(1, 2);
+int emsg_warnn(const char *fmt, ...) EMSG_PRINTF(1, 2);
+
+/* Like eerror/eerrorn, return 1 */
+int emsg_error(const char *fmt, ...) EMSG_PRINTF(1, 2);
+int emsg_errorn(const char *fmt, ...) EMSG_PRINTF(1, 2);
+
+/* Like ebegin, return 0 */
+int emsg_begin(const char *fmt, ...) EMSG_PRINTF(1, 2);
+
+/*
+ * Like eend and ewend: close the calling thread's last ebegin and
+ * return retval. If retval is not 0 and fmt is not NULL, the message
+ * is shown as an error or a warning first.
+ */
+int emsg_end(int retval, const char *fmt, ...) EMSG_PRINTF(2, 3);
+int emsg_wend(int retval, const char *fmt, ...) EMSG_PRINTF(2, 3);
+
+/* Like eindent and eoutdent, for the calling thread */
+void emsg_indent(void);
+void emsg_outdent(void);
+
+/* Wait until everything queued so far has been written */
+void emsg_flush(void);
+
+/*
+ * Write what is queued and stop the writer thread. This is also done
+ * at exit. Messages sent afterwards are written by the caller.
+ */
+void emsg_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,695 @@
+/*
+ * eparse.c
+ * index transcripts of functions.sh output, such as saved boot or
+ * deploy logs, and search the index: which ebegin/eend spans failed or
+ * never finished, and which warnings and errors were shown, without
+ * reading the logs again.
+ *
+ * The logs are read through mmap and taken apart line by line as
+ * einfo, ewarn, eerror, ebegin and eend write them: the " * " marker
+ * and its colour, the RC_INDENTATION depth, and the status eend puts
+ * at the end of the ebegin line, through ENDCOL or padded with spaces
+ * on serial consoles. EINFO_LOGFILE and estrip output is read too.
+ * Spans nest as in functions.sh: a status closes the last ebegin still
+ * open.
+ *
+ * The index holds a block per log: its path, size and mtime, then the
+ * records and their strings. Blocks of logs that did not change are
+ * copied as they are when the index is updated. It is written in the
+ * byte order of the machine.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <regex.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "escape.h"
+
+#define MAGIC		"EPARSE1\n"
+#define MAX_DEPTH	64
+
+enum rectype {
+	SPAN_OK,		/* a span that ended with [ ok ] */
+	SPAN_FAIL,		/* a span that ended with [ !! ] */
+	SPAN_OPEN,		/* a span that never ended */
+	MSG_WARN,
+	MSG_ERROR,
+	NTYPES
+};
+
+static const char *const type_names[NTYPES] = {
+	"ok", "fail", "open", "warn", "error"
+};
+
+struct rec {
+	uint32_t line;		/* of the ebegin or the message */
+	uint32_t msg;		/* offsets into the strings */
+	uint32_t reason;	/* the last warning or error inside a span */
+	int32_t ms;		/* the time eend showed, or -1 */
+	uint8_t type;
+	uint8_t indent;
+	uint16_t pad;
+};
+
+struct block {
+	uint64_t size;
+	int64_t mtime;
+	uint32_t nrec;
+	uint32_t strsize;
+	uint32_t pathlen;	/* with the NUL, padded to 8 */
+	uint32_t pad;
+	/* path, records, strings */
+};
+
+/* the index being built */
+static struct {
+	struct rec *recs;
+	size_t nrec, recsize;
+	char *strs;
+	size_t strlen, strsize;
+	uint32_t *hash;		/* offsets of the strings, to store each once */
+	size_t nhash, hashsize;
+} ix;
+
+/* the spans still open, innermost last */
+static struct {
+	uint32_t line, msg, reason;
+	uint8_t indent;
+} stack[MAX_DEPTH];
+static int depth;
+
+/* the last message outside of any span, and its indent */
+static uint32_t loose;
+static size_t loose_indent;
+
+static void *xrealloc(void *p, size_t n)
+{
+	p = realloc(p, n);
+	if (p == NULL) {
+		perror("eparse");
+		exit(1);
+	}
+	return p;
+}
+
+static size_t hash_str(const char *s, size_t n)
+{
+	size_t h = 2166136261u;
+
+	while (n-- > 0)
+		h = (h ^ (unsigned char)*s++) * 16777619u;
+	return h;
+}
+
+static uint32_t add_str(const char *s, size_t n)
+{
+	uint32_t off = ix.strlen, *old;
+	size_t i, j, oldsize;
+
+	if (n == 0)
+		return 0;
+
+	/* Boot after boot, logs repeat the same messages */
+	if (ix.nhash * 2 >= ix.hashsize) {
+		old = ix.hash;
+		oldsize = ix.hashsize;
+		ix.hashsize = oldsize ? oldsize * 2 : 1024;
+		ix.hash = calloc(ix.hashsize, sizeof(*ix.hash));
+		if (ix.hash == NULL) {
+			perror("eparse");
+			exit(1);
+		}
+		for (j = 0; j < oldsize; j++) {
+			if (old[j] == 0)
+				continue;
+			i = hash_str(ix.strs + old[j], strlen(ix.strs + old[j]));
+			while (ix.hash[i & (ix.hashsize - 1)] != 0)
+				i++;
+			ix.hash[i & (ix.hashsize - 1)] = old[j];
+		}
+		free(old);
+	}
+	for (i = hash_str(s, n); ix.hash[i & (ix.hashsize - 1)] != 0; i++) {
+		j = ix.hash[i & (ix.hashsize - 1)];
+		if (strncmp(ix.strs + j, s, n) == 0 && ix.strs[j + n] == '\0')
+			return j;
+	}
+	ix.hash[i & (ix.hashsize - 1)] = off;
+	ix.nhash++;
+
+	if (ix.strlen + n + 1 > ix.strsize) {
+		ix.strsize = (ix.strlen + n + 1) * 2;
+		ix.strs = xrealloc(ix.strs, ix.strsize);
+	}
+	memcpy(ix.strs + ix.strlen, s, n);
+	ix.strs[ix.strlen + n] = '\0';
+	ix.strlen += n + 1;
+	return off;
+}
+
+static void add_rec(int type, uint32_t line, uint32_t msg, uint32_t reason,
+		    int ms, int indent)
+{
+	struct rec *r;
+
+	if (ix.nrec == ix.recsize) {
+		ix.recsize = ix.recsize * 2 + 256;
+		ix.recs = xrealloc(ix.recs, ix.recsize * sizeof(*r));
+	}
+	r = &ix.recs[ix.nrec++];
+	memset(r, 0, sizeof(*r));
+	r->type = type;
+	r->line = line;
+	r->msg = msg;
+	r->reason = reason;
+	r->ms = ms;
+	r->indent = indent > 255 ? 255 : indent;
+}
+
+static void close_span(int type, int ms)
+{
+	if (depth == 0)
+		return;
+	depth--;
+	add_rec(type, stack[depth].line, stack[depth].msg,
+		stack[depth].reason, ms, stack[depth].indent);
+}
+
+/*
+ * Does the line end in a status, "[ ok ]" or "[ !! ]", maybe after
+ * the "(1.234s) " of EINFO_TIMING? Returns the type and leaves in *cut
+ * where the spaces before it start.
+ */
+static int tail_status(const char *s, size_t n, size_t *cut, int *ms)
+{
+	size_t j, k;
+	int type, sec = 0, frac = 0;
+
+	while (n > 0 && (s[n - 1] == ' ' || s[n - 1] == '\r'))
+		n--;
+	if (n < 6)
+		return -1;
+	if (memcmp(s + n - 6, "[ ok ]", 6) == 0)
+		type = SPAN_OK;
+	else if (memcmp(s + n - 6, "[ !! ]", 6) == 0)
+		type = SPAN_FAIL;
+	else
+		return -1;
+
+	*ms = -1;
+	j = n - 6;
+	if (j >= 2 && s[j - 1] == ' ' && s[j - 2] == ')') {
+		for (k = j - 2; k > 0 && s[k - 1] != '('; k--)
+			;
+		if (k > 0 && sscanf(s + k, "%d.%3ds)", &sec, &frac) == 2) {
+			*ms = sec * 1000 + frac;
+			j = k - 1;
+		}
+	}
+	while (j > 0 && s[j - 1] == ' ')
+		j--;
+	*cut = j;
+	return type;
+}
+
+static int ends_with_dots(const char *s, size_t n)
+{
+	return n >= 4 && memcmp(s + n - 4, " ...", 4) == 0;
+}
+
+/*
+ * One line without its escapes. up is set if it started with a cursor
+ * up, which is how ENDCOL gets back to the ebegin line. colour is the
+ * colour of the " * " marker.
+ */
+static void parse_line(const char *s, size_t n, uint32_t line, int up,
+		       int colour, int coloured)
+{
+	const char *stamp;
+	size_t cut = 0, indent;
+	uint32_t msg, reason;
+	int type, ms = -1, logfile = 0;
+
+	/* EINFO_LOGFILE puts the uptime first */
+	if (n > 0 && *s == '[' && (stamp = memchr(s, ']', n)) != NULL &&
+	    (size_t)(stamp + 4 - s) <= n && memcmp(stamp + 1, " * ", 3) == 0) {
+		n -= stamp + 1 - s;
+		s = stamp + 1;
+		logfile = 1;
+	}
+	while (n > 0 && (s[n - 1] == '\r' || s[n - 1] == ' '))
+		n--;
+	type = tail_status(s, n, &cut, &ms);
+
+	if (n < 3 || memcmp(s, " * ", 3) != 0) {
+		/* ENDCOL, or the status on a line of its own on serial */
+		if (type >= 0 && cut == 0)
+			close_span(type, ms);
+		return;
+	}
+	if (up)
+		return;
+
+	s += 3;
+	n -= 3;
+	if (type >= 0)
+		n = cut > 3 ? cut - 3 : 0;
+	for (indent = 0; indent < n && s[indent] == ' '; indent++)
+		;
+
+	/*
+	 * ebegin, and on serial consoles the eend on the same line.
+	 * EINFO_LOGFILE only has the line with the status, written by
+	 * eend after what was shown inside the span: the message before
+	 * it is taken as the reason a span failed.
+	 */
+	if (n >= indent + 4 && ends_with_dots(s, n)) {
+		if (type >= 0) {
+			reason = logfile && type == SPAN_FAIL &&
+				loose_indent >= indent ? loose : 0;
+			loose = 0;
+			add_rec(type, line, add_str(s + indent, n - 4 - indent),
+				reason, ms, indent);
+			return;
+		}
+		loose = 0;
+		if (depth == MAX_DEPTH)
+			close_span(SPAN_OPEN, -1);
+		stack[depth].line = line;
+		stack[depth].msg = add_str(s + indent, n - 4 - indent);
+		stack[depth].reason = 0;
+		stack[depth].indent = indent;
+		depth++;
+		return;
+	}
+
+	/*
+	 * Without colours, warnings and errors look like einfo: the last
+	 * message of a span is taken as the reason it failed.
+	 */
+	if (!coloured || colour == 3 || colour == 1) {
+		msg = add_str(s + indent, n - indent);
+		if (depth > 0) {
+			stack[depth - 1].reason = msg;
+		} else {
+			loose = msg;
+			loose_indent = indent;
+		}
+		if (coloured)
+			add_rec(colour == 1 ? MSG_ERROR : MSG_WARN, line, msg, 0,
+				-1, indent);
+	}
+
+	/* The status ENDCOL put after the message, as estrip leaves it */
+	if (type >= 0)
+		close_span(type, ms);
+}
+
+static int cmp_rec(const void *a, const void *b)
+{
+	const struct rec *x = a, *y = b;
+
+	return x->line < y->line ? -1 : x->line > y->line;
+}
+
+/* fill ix from the log at [p, p + n) */
+static void parse(const char *p, size_t n)
+{
+	const char *end = p + n, *eol, *s, *e;
+	char *text = NULL;
+	size_t size = 0, len;
+	uint32_t line = 0;
+	int fg, colour, marked, coloured = 0, up;
+	struct esc esc;
+
+	/* Offset 0 is the empty string */
+	if (ix.strs == NULL) {
+		ix.strsize = 4096;
+		ix.strs = xrealloc(NULL, ix.strsize);
+	}
+	ix.nrec = 0;
+	ix.strlen = 1;
+	ix.strs[0] = '\0';
+	if (ix.hash != NULL)
+		memset(ix.hash, 0, ix.hashsize * sizeof(*ix.hash));
+	ix.nhash = 0;
+	depth = 0;
+	loose = 0;
+
+	for (; p < end; p = eol + 1) {
+		line++;
+		eol = memchr(p, '\n', end - p);
+		if (eol == NULL)
+			eol = end;
+		if ((size_t)(eol - p) + 1 > size) {
+			size = (eol - p) * 2 + 256;
+			text = xrealloc(text, size);
+		}
+
+		/* Take the escapes out, noting the colour of the marker */
+		len = 0;
+		fg = -1;
+		colour = -1;
+		marked = up = 0;
+		for (s = p; s < eol; s = e + esc.len) {
+			e = esc_find(s, eol);
+			memcpy(text + len, s, e - s);
+			len += e - s;
+			if (!marked && len >= 2) {
+				marked = 1;
+				colour = fg;
+			}
+			if (e == eol)
+				break;
+			esc_parse(e, eol, &esc);
+			if (esc.type == ESC_INCOMPLETE)
+				break;
+			if (esc.type == ESC_UP && e == p)
+				up = 1;
+			fg = esc_colour(e, esc.len, fg);
+			coloured |= fg >= 0;
+		}
+		parse_line(text, len, line, up, colour, coloured);
+	}
+	while (depth > 0)
+		close_span(SPAN_OPEN, -1);
+	free(text);
+
+	qsort(ix.recs, ix.nrec, sizeof(*ix.recs), cmp_rec);
+}
+
+static size_t pad8(size_t n)
+{
+	return (n + 7) & ~(size_t)7;
+}
+
+static uint64_t block_len(const struct block *b)
+{
+	return sizeof(*b) + (uint64_t)b->pathlen +
+		pad8((uint64_t)b->nrec * sizeof(struct rec) + b->strsize);
+}
+
+/*
+ * the next block of the index at [p, end) in *bp: 1 for a block, 0 at
+ * the end and -1 if what is there is not a block. Everything the block
+ * points to is checked to lie within it, so a broken index is refused
+ * rather than read past.
+ */
+static int next_block(const char **p, const char *end,
+		      const struct block **bp)
+{
+	const struct block *b = (const struct block *)*p;
+	const struct rec *r;
+	const char *path, *strs;
+	uint32_t i;
+
+	if (*p == end)
+		return 0;
+	if ((size_t)(end - *p) < sizeof(*b) ||
+	    (uint64_t)(end - *p) < block_len(b) ||
+	    b->pathlen == 0 || b->pathlen % 8 != 0)
+		return -1;
+
+	path = (const char *)(b + 1);
+	r = (const struct rec *)(path + b->pathlen);
+	strs = (const char *)(r + b->nrec);
+	if (memchr(path, '\0', b->pathlen) == NULL ||
+	    (b->strsize > 0 && strs[b->strsize - 1] != '\0'))
+		return -1;
+	for (i = 0; i < b->nrec; i++, r++)
+		if (r->type >= NTYPES || r->msg >= b->strsize ||
+		    r->reason >= b->strsize)
+			return -1;
+
+	*p += block_len(b);
+	*bp = b;
+	return 1;
+}
+
+/* write n bytes and then zeroes up to the next multiple of 8 after to */
+static int write_pad(FILE *f, const void *p, size_t n, size_t to)
+{
+	static const char zero[8];
+
+	if (fwrite(p, 1, n, f) != n)
+		return -1;
+	n = pad8(to) - to;
+	return fwrite(zero, 1, n, f) == n ? 0 : -1;
+}
+
+static char *map_file(const char *path, size_t *n, struct stat *st)
+{
+	static char empty[1];
+	char *p;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, st) < 0) {
+		close(fd);
+		return NULL;
+	}
+	*n = st->st_size;
+	p = *n > 0 ? mmap(NULL, *n, PROT_READ, MAP_PRIVATE, fd, 0) : empty;
+	close(fd);
+	if (p == MAP_FAILED)
+		return NULL;
+	if (*n > 0)
+		madvise(p, *n, MADV_SEQUENTIAL);
+	return p;
+}
+
+/* add the logs to the index, parsing only those that changed */
+static int update(const char *index, char **logs, int nlogs)
+{
+	const struct block *b;
+	const char *old = NULL, *p, *end, *path;
+	char *tmp, **paths, *log;
+	size_t oldlen = 0, loglen;
+	struct block nb;
+	struct stat st;
+	FILE *f;
+	int i, ret = 0, more;
+
+	paths = calloc(nlogs, sizeof(*paths));
+	if (paths == NULL) {
+		perror("eparse");
+		return 1;
+	}
+	for (i = 0; i < nlogs; i++) {
+		paths[i] = realpath(logs[i], NULL);
+		if (paths[i] == NULL) {
+			perror(logs[i]);
+			ret = 1;
+		}
+	}
+
+	if (asprintf(&tmp, "%s.%d", index, (int)getpid()) < 0) {
+		perror("eparse");
+		return 1;
+	}
+	f = fopen(tmp, "we");
+	if (f == NULL) {
+		perror(tmp);
+		return 1;
+	}
+	fputs(MAGIC, f);
+
+	old = map_file(index, &oldlen, &st);
+	if (old != NULL && (oldlen < 8 || memcmp(old, MAGIC, 8) != 0)) {
+		fprintf(stderr, "eparse: %s: not an index\n", index);
+		fclose(f);
+		unlink(tmp);
+		return 1;
+	}
+
+	/* Keep what is still up to date */
+	if (old != NULL) {
+		end = old + oldlen;
+		p = old + 8;
+		while ((more = next_block(&p, end, &b)) > 0) {
+			path = (const char *)(b + 1);
+			for (i = 0; i < nlogs; i++)
+				if (paths[i] != NULL && strcmp(paths[i], path) == 0)
+					break;
+			if (i < nlogs && stat(path, &st) == 0 &&
+			    (uint64_t)st.st_size == b->size &&
+			    st.st_mtime == b->mtime) {
+				free(paths[i]);
+				paths[i] = NULL;
+			}
+			if (i == nlogs || paths[i] == NULL)
+				fwrite(b, 1, block_len(b), f);
+		}
+		if (more < 0) {
+			fprintf(stderr, "eparse: %s: not an index\n", index);
+			munmap((void *)old, oldlen);
+			fclose(f);
+			unlink(tmp);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < nlogs; i++) {
+		if (paths[i] == NULL)
+			continue;
+		log = map_file(paths[i], &loglen, &st);
+		if (log == NULL) {
+			perror(logs[i]);
+			ret = 1;
+			continue;
+		}
+		parse(log, loglen);
+		if (loglen > 0)
+			munmap(log, loglen);
+
+		memset(&nb, 0, sizeof(nb));
+		nb.size = st.st_size;
+		nb.mtime = st.st_mtime;
+		nb.nrec = ix.nrec;
+		nb.strsize = ix.strlen;
+		nb.pathlen = pad8(strlen(paths[i]) + 1);
+		if (fwrite(&nb, sizeof(nb), 1, f) != 1 ||
+		    write_pad(f, paths[i], strlen(paths[i]) + 1,
+			      strlen(paths[i]) + 1) < 0 ||
+		    fwrite(ix.recs, sizeof(*ix.recs), ix.nrec, f) != ix.nrec ||
+		    write_pad(f, ix.strs, ix.strlen,
+			      ix.nrec * sizeof(*ix.recs) + ix.strlen) < 0)
+			break;
+		free(paths[i]);
+	}
+
+	if (old != NULL && oldlen > 0)
+		munmap((void *)old, oldlen);
+	if (ferror(f) | fclose(f) || rename(tmp, index) < 0) {
+		perror(tmp);
+		unlink(tmp);
+		ret = 1;
+	}
+	free(tmp);
+	free(paths);
+	return ret;
+}
+
+/* print the records of the given types matching re, or all of them */
+static int query(const char *index, unsigned types, const regex_t *re)
+{
+	const struct block *b;
+	const struct rec *r;
+	const char *p, *end, *idx, *path, *strs, *msg, *reason;
+	size_t len;
+	struct stat st;
+	uint32_t i;
+	int found = 0, more;
+
+	idx = map_file(index, &len, &st);
+	if (idx == NULL) {
+		perror(index);
+		return 2;
+	}
+	if (len < 8 || memcmp(idx, MAGIC, 8) != 0) {
+		fprintf(stderr, "eparse: %s: not an index\n", index);
+		return 2;
+	}
+
+	end = idx + len;
+	p = idx + 8;
+	while ((more = next_block(&p, end, &b)) > 0) {
+		path = (const char *)(b + 1);
+		r = (const struct rec *)(path + b->pathlen);
+		strs = (const char *)(r + b->nrec);
+		for (i = 0; i < b->nrec; i++, r++) {
+			if (!(types & 1u << r->type))
+				continue;
+			msg = strs + r->msg;
+			reason = strs + r->reason;
+			if (re != NULL && regexec(re, msg, 0, NULL, 0) != 0 &&
+			    (*reason == '\0' || regexec(re, reason, 0, NULL, 0) != 0))
+				continue;
+			found = 1;
+			printf("%s:%u: %s: %s", path, r->line, type_names[r->type], msg);
+			if (r->ms >= 0)
+				printf(" (%d.%03ds)", r->ms / 1000, r->ms % 1000);
+			if (*reason != '\0')
+				printf(": %s", reason);
+			putchar('\n');
+		}
+	}
+	if (more < 0) {
+		fprintf(stderr, "eparse: %s: not an index\n", index);
+		return 2;
+	}
+	return found ? 0 : 1;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "Usage: %s [-i index] -u log...\n"
+			"       %s [-i index] [-t type]... [pattern]\n",
+		argv0, argv0);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *index = "eparse.idx";
+	unsigned types = 0;
+	regex_t re;
+	int opt, t, do_update = 0, ret;
+
+	while ((opt = getopt(argc, argv, "i:t:u")) != -1) {
+		switch (opt) {
+		case 'i':
+			index = optarg;
+			break;
+		case 't':
+			for (t = 0; t < NTYPES; t++)
+				if (strcmp(optarg, type_names[t]) == 0)
+					break;
+			if (strcmp(optarg, "span") == 0)
+				types |= 1u << SPAN_OK | 1u << SPAN_FAIL | 1u << SPAN_OPEN;
+			else if (t == NTYPES)
+				usage(argv[0]);
+			else
+				types |= 1u << t;
+			break;
+		case 'u':
+			do_update = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (do_update) {
+		if (optind == argc || types != 0)
+			usage(argv[0]);
+		return update(index, argv + optind, argc - optind);
+	}
+
+	if (argc - optind > 1)
+		usage(argv[0]);
+	/* By default, everything that went wrong */
+	if (types == 0)
+		types = ~(1u << SPAN_OK);
+	if (optind == argc)
+		return query(index, types, NULL);
+	if (regcomp(&re, argv[optind], REG_EXTENDED | REG_NOSUB) != 0) {
+		fprintf(stderr, "eparse: bad pattern: %s\n", argv[optind]);
+		return 2;
+	}
+	ret = query(index, types, &re);
+	regfree(&re);
+	return ret;
+}
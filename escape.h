@@ -0,0 +1,182 @@
+/*
+ * escape.h
+ * finding and decoding the escape sequences functions.sh writes: the
+ * colours, ENDCOL's "\033[A\033[<n>C", the moves and erasing of the
+ * status board, and whatever tput puts in the colours, such as
+ * "\033(B". Shared by estrip and eparse.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define ESC	'\033'
+
+/* A sequence this long without an end is taken as junk */
+#define ESC_MAX	64
+
+enum esc_type {
+	ESC_INCOMPLETE,		/* runs past the end of the input */
+	ESC_UP,			/* cursor up, "\033[<n>A" */
+	ESC_DOWN,		/* cursor down, "\033[<n>B" */
+	ESC_FORWARD,		/* cursor forward, "\033[<n>C" */
+	ESC_ERASE_BELOW,	/* to the end of the screen, "\033[J" */
+	ESC_ERASE_LINE,		/* to the end of the line, "\033[K" */
+	ESC_OTHER,		/* colours, charsets, ... */
+};
+
+struct esc {
+	enum esc_type type;
+	unsigned arg;		/* the first parameter, or 1 */
+	size_t len;
+};
+
+/* the first ESC in [p, end), or end */
+static inline const char *esc_find(const char *p, const char *end)
+{
+#ifdef __SSE2__
+	const __m128i e = _mm_set1_epi8(ESC);
+	__m128i a, b, c, d;
+	const char *short_end = end - p > 16 ? p + 16 : end;
+	uint64_t m;
+
+	/* Between colours the next one is close, and loads do not pay */
+	for (; p < short_end; p++)
+		if (*p == ESC)
+			return p;
+
+	/* Look at 64 bytes at a time, most logs have long runs without */
+	while (end - p >= 64) {
+		a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), e);
+		b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 16)), e);
+		c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 32)), e);
+		d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 48)), e);
+		if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b),
+						   _mm_or_si128(c, d)))) {
+			m = (uint64_t)_mm_movemask_epi8(a) |
+				(uint64_t)_mm_movemask_epi8(b) << 16 |
+				(uint64_t)_mm_movemask_epi8(c) << 32 |
+				(uint64_t)_mm_movemask_epi8(d) << 48;
+			return p + __builtin_ctzll(m);
+		}
+		p += 64;
+	}
+	while (end - p >= 16) {
+		a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), e);
+		if (_mm_movemask_epi8(a))
+			return p + __builtin_ctz(_mm_movemask_epi8(a));
+		p += 16;
+	}
+#endif
+	for (; p < end; p++)
+		if (*p == ESC)
+			return p;
+	return end;
+}
+
+/* decode the sequence starting with the ESC at p */
+static inline void esc_parse(const char *p, const char *end, struct esc *e)
+{
+	const char *q = p + 2;
+	unsigned arg = 0;
+	int digits = 1;
+
+	e->type = ESC_INCOMPLETE;
+	e->arg = 1;
+	e->len = end - p;
+	if (end - p < 2)
+		goto incomplete;
+
+	switch (p[1]) {
+	case '[':
+		break;
+	case '(': case ')': case '*': case '+':
+		/* Character set designation, "\033(B" from tput sgr0 */
+		if (end - p < 3)
+			goto incomplete;
+		e->type = ESC_OTHER;
+		e->len = 3;
+		return;
+	default:
+		e->type = ESC_OTHER;
+		e->len = 2;
+		return;
+	}
+
+	/* Control sequence: parameters, intermediates, final byte */
+	for (; q < end && *q >= 0x30 && *q <= 0x3f; q++) {
+		if (digits && *q >= '0' && *q <= '9')
+			arg = arg * 10 + (*q - '0');
+		else
+			digits = 0;
+	}
+	while (q < end && *q >= 0x20 && *q <= 0x2f)
+		q++;
+	if (q == end)
+		goto incomplete;
+
+	e->type = ESC_OTHER;
+	if (arg > 0)
+		e->arg = arg;
+	if (*q == 'A')
+		e->type = ESC_UP;
+	else if (*q == 'B')
+		e->type = ESC_DOWN;
+	else if (*q == 'C')
+		e->type = ESC_FORWARD;
+	/* Only the plain forms, from the cursor on, are ever written */
+	else if (*q == 'J' && arg == 0 && q == p + 2)
+		e->type = ESC_ERASE_BELOW;
+	else if (*q == 'K' && arg == 0 && q == p + 2)
+		e->type = ESC_ERASE_LINE;
+	/* A broken sequence loses what was read of it, not the next byte */
+	e->len = q - p + (*q >= 0x40 && *q <= 0x7e);
+	return;
+
+incomplete:
+	if (end - p >= ESC_MAX) {
+		e->type = ESC_OTHER;
+		e->len = 1;
+	}
+}
+
+/*
+ * the foreground colour (0 to 7) after the colour sequence p of len
+ * bytes, given the one before: -1 for the default. As set by GOOD
+ * ("\033[32;01m") and the like, or by tput setaf.
+ */
+static inline int esc_colour(const char *p, size_t len, int fg)
+{
+	const char *end = p + len - 1;
+	unsigned n = 0;
+
+	if (len < 3 || p[1] != '[' || *end != 'm')
+		return fg;
+	if (len == 3)
+		return -1;
+	for (p += 2; p <= end; p++) {
+		if (*p >= '0' && *p <= '9') {
+			n = n * 10 + (*p - '0');
+			continue;
+		}
+		/* 38 and 48 take more parameters, which are left alone */
+		if (n == 0 || n == 39)
+			fg = -1;
+		else if (n >= 30 && n <= 37)
+			fg = n - 30;
+		else if (n == 38 || n == 48)
+			break;
+		n = 0;
+	}
+	return fg;
+}
+
+#endif
@@ -0,0 +1,364 @@
+/*
+ * estrip.c
+ * turn transcripts of functions.sh output back into plain text: the
+ * colours are removed, the status eend writes over the end of its
+ * ebegin line through ENDCOL is put on that line again, and what the
+ * status board draws below the messages goes as it does on screen.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "escape.h"
+
+#define CHUNK	(256 * 1024)
+
+/* Lines held back for the board to go up into, it has one per job */
+#define HOLD	256
+
+static char *out;
+static size_t len, size = 4 * CHUNK;
+
+static int pad;			/* -p: put the status where it was shown */
+static int reopened;		/* a cursor up took back the last newline */
+static int squeeze;		/* the spaces before a status become one */
+static ssize_t mark = -1;	/* where the status was put into its line */
+static unsigned board_up;	/* lines the board went up from the end */
+static size_t edit;		/* where the board writes, if it went up */
+
+static void write_out(const char *p, size_t n)
+{
+	ssize_t w;
+
+	while (n > 0) {
+		w = write(STDOUT_FILENO, p, n);
+		if (w < 0 && errno == EINTR)
+			continue;
+		if (w < 0) {
+			perror("estrip: write");
+			exit(1);
+		}
+		p += w;
+		n -= w;
+	}
+}
+
+/*
+ * Write out all but the last HOLD lines, which a later cursor up may
+ * still go back into. The last line is a whole one if the output ends
+ * with a newline.
+ */
+static void flush(int all)
+{
+	char *nl;
+	size_t keep = len, n;
+	int i;
+
+	if (!all && len > 0) {
+		keep = 0;
+		n = out[len - 1] == '\n' ? len - 1 : len;
+		for (i = 0; i < HOLD && (nl = memrchr(out, '\n', n)) != NULL; i++) {
+			n = nl - out;
+			keep = n + 1;
+		}
+	}
+	/* A line as big as the buffer cannot be held back */
+	if (keep == 0)
+		keep = len;
+
+	write_out(out, keep);
+	memmove(out, out + keep, len - keep);
+	len -= keep;
+	mark = mark < (ssize_t)keep ? -1 : mark - (ssize_t)keep;
+	edit = edit < keep ? 0 : edit - keep;
+}
+
+static void reserve(size_t n)
+{
+	if (len + n <= size)
+		return;
+	flush(0);
+	if (len + n <= size)
+		return;
+	size = (len + n) * 2;
+	out = realloc(out, size);
+	if (out == NULL) {
+		perror("estrip");
+		exit(1);
+	}
+}
+
+static void emit(const char *p, size_t n)
+{
+	size_t c;
+
+	if (n == 0)
+		return;
+	if (board_up > 0) {
+		/* A board line written anew, in the middle of the output */
+		reserve(n);
+		memmove(out + edit + n, out + edit, len - edit);
+		memcpy(out + edit, p, n);
+		len += n;
+		edit += n;
+		return;
+	}
+	if (!reopened && !squeeze && len + n <= size) {
+		memcpy(out + len, p, n);
+		len += n;
+		return;
+	}
+	if (reopened) {
+		/* Cursor up without ENDCOL: keep the line as it was */
+		reopened = 0;
+		reserve(1);
+		out[len++] = '\n';
+	}
+	if (squeeze) {
+		while (n > 0 && *p == ' ')
+			p++, n--;
+		if (n == 0)
+			return;
+		squeeze = 0;
+		reserve(1);
+		out[len++] = ' ';
+	}
+	while (n > 0) {
+		c = n < CHUNK ? n : CHUNK;
+		reserve(c);
+		memcpy(out + len, p, c);
+		len += c;
+		p += c;
+		n -= c;
+	}
+}
+
+/* the status goes to column col of the line taken back */
+static void endcol(unsigned col)
+{
+	char *nl = memrchr(out, '\n', len);
+	size_t start = nl ? (size_t)(nl + 1 - out) : 0, i;
+	unsigned n = 0;
+
+	reopened = 0;
+	if (!pad) {
+		/* A second status, like eend after eprogress, replaces the first */
+		if (mark >= (ssize_t)start)
+			len = mark;
+		else
+			mark = len;
+		squeeze = 1;
+		return;
+	}
+
+	/* Count characters, not the bytes of UTF-8 sequences */
+	for (i = start; i < len; i++) {
+		if ((out[i] & 0xc0) != 0x80 && n++ == col)
+			break;
+	}
+	if (i < len) {
+		len = i;
+		return;
+	}
+	reserve(col - n);
+	memset(out + len, ' ', col - n);
+	len += col - n;
+}
+
+/* the start of the line n lines above the last one */
+static size_t line_above(unsigned n)
+{
+	char *nl = memrchr(out, '\n', len);
+	size_t pos = nl ? (size_t)(nl + 1 - out) : 0;
+
+	while (n-- > 0 && pos > 0) {
+		nl = memrchr(out, '\n', pos - 1);
+		pos = nl ? (size_t)(nl + 1 - out) : 0;
+	}
+	return pos;
+}
+
+/* the board goes up n lines from the end, or back down to it for 0 */
+static void board_move(unsigned n)
+{
+	board_up = n;
+	if (n == 0)
+		return;
+	edit = line_above(n);
+	/* What the status went into is gone or out of reach */
+	if (mark >= (ssize_t)edit)
+		mark = -1;
+}
+
+/* strip [p, p + n), return how much was used */
+static size_t strip(const char *p, size_t n, int eof)
+{
+	const char *end = p + n, *s = p, *e, *next;
+	char *nl;
+	struct esc esc;
+
+	while (s < end) {
+		/* Colours come in runs, do not go looking for the next one */
+		if (*s == ESC) {
+			e = s;
+		} else {
+			e = esc_find(s, end);
+			emit(s, e - s);
+			if (e == end)
+				break;
+		}
+
+		esc_parse(e, end, &esc);
+		next = e + esc.len;
+		switch (esc.type) {
+		case ESC_INCOMPLETE:
+			if (!eof)
+				return e - p;
+			esc.len = end - e;
+			break;
+		case ESC_UP:
+			/* The board moves with a carriage return after */
+			if (next == end && !eof)
+				return e - p;
+			if (next < end && *next == '\r') {
+				board_move(esc.arg);
+				esc.len++;
+				break;
+			}
+			if (esc.arg == 1 && !reopened && len > 0 &&
+			    out[len - 1] == '\n') {
+				len--;
+				reopened = 1;
+			}
+			break;
+		case ESC_DOWN:
+			if (next == end && !eof)
+				return e - p;
+			if (board_up > 0)
+				board_move(esc.arg < board_up ? board_up - esc.arg : 0);
+			if (next < end && *next == '\r')
+				esc.len++;
+			break;
+		case ESC_FORWARD:
+			if (reopened)
+				endcol(esc.arg);
+			break;
+		case ESC_ERASE_BELOW:
+			/* The board taken off the screen, or drawn anew */
+			if (board_up > 0) {
+				len = edit;
+				board_up = 0;
+			}
+			break;
+		case ESC_ERASE_LINE:
+			if (board_up > 0) {
+				nl = memchr(out + edit, '\n', len - edit);
+				if (nl == NULL)
+					nl = out + len;
+				memmove(out + edit, nl, out + len - nl);
+				len -= nl - (out + edit);
+			}
+			break;
+		case ESC_OTHER:
+			break;
+		}
+		s = e + esc.len;
+	}
+	return n;
+}
+
+static int strip_fd(int fd, const char *name)
+{
+	struct stat st;
+	char *map, *buf;
+	size_t have = 0, used;
+	ssize_t n;
+
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			madvise(map, st.st_size, MADV_SEQUENTIAL);
+			strip(map, st.st_size, 1);
+			munmap(map, st.st_size);
+			return 0;
+		}
+	}
+
+	/* Pipes and the like, a sequence may be split between reads */
+	buf = malloc(CHUNK + ESC_MAX);
+	if (buf == NULL) {
+		perror("estrip");
+		return 1;
+	}
+	for (;;) {
+		n = read(fd, buf + have, CHUNK);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0) {
+			perror(name);
+			free(buf);
+			return 1;
+		}
+		have += n;
+		used = strip(buf, have, n == 0);
+		if (n == 0)
+			break;
+		have -= used;
+		memmove(buf, buf + used, have);
+	}
+	free(buf);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, fd, i, ret = 0;
+
+	while ((opt = getopt(argc, argv, "p")) != -1) {
+		if (opt != 'p') {
+			fprintf(stderr, "Usage: %s [-p] [file]...\n", argv[0]);
+			return 2;
+		}
+		pad = 1;
+	}
+
+	out = malloc(size);
+	if (out == NULL) {
+		perror("estrip");
+		return 1;
+	}
+
+	if (optind == argc)
+		ret |= strip_fd(STDIN_FILENO, "stdin");
+	for (i = optind; i < argc; i++) {
+		if (strcmp(argv[i], "-") == 0) {
+			ret |= strip_fd(STDIN_FILENO, "stdin");
+			continue;
+		}
+		fd = open(argv[i], O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			perror(argv[i]);
+			ret = 1;
+			continue;
+		}
+		ret |= strip_fd(fd, argv[i]);
+		close(fd);
+	}
+
+	if (reopened) {
+		reserve(1);
+		out[len++] = '\n';
+	}
+	flush(1);
+	return ret;
+}
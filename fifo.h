@@ -0,0 +1,75 @@
+/*
+ * fifo.h
+ * the helper side of the FIFOs functions.sh writes into, shared by
+ * econsole and ejournal. The script opens the FIFO read-write, so that
+ * writing never raises SIGPIPE, and runs the helper in the foreground. The helper opens it for reading, makes
+ * the script's end non-blocking and then goes into the background, so
+ * its exit status tells the script that somebody reads the FIFO.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#ifndef FIFO_H
+#define FIFO_H
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+
+/*
+ * open the FIFO at path for reading and remove it. The script's end,
+ * inherited as fd w, is made non-blocking: the flag belongs to the open
+ * file, which the script shares. Returns the read end, or -1.
+ */
+static inline int fifo_open(const char *path, int w)
+{
+	int in, flags;
+
+	in = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (in < 0)
+		return -1;
+	unlink(path);
+
+	if (w >= 0) {
+		flags = fcntl(w, F_GETFL);
+		if (flags < 0 || fcntl(w, F_SETFL, flags | O_NONBLOCK) < 0) {
+			close(in);
+			return -1;
+		}
+		/* Our copy would keep the FIFO from ever reaching its end */
+		close(w);
+	}
+	return in;
+}
+
+/*
+ * a descriptor that becomes readable once the process pid is gone, or
+ * -1. The script cannot make its end close-on-exec, so whatever it
+ * starts may hold the FIFO open long after the script is done.
+ */
+static inline int fifo_watch(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+	if (pid > 0)
+		return syscall(SYS_pidfd_open, pid, 0);
+#endif
+	return -1;
+}
+
+/* go into the background, the script goes on when we exit */
+static inline void fifo_detach(void)
+{
+	switch (fork()) {
+	case -1:
+		exit(1);
+	case 0:
+		return;
+	default:
+		_exit(0);
+	}
+}
+
+#endif
@@ -5,19 +5,70 @@
 # All functions in this file should be written in POSIX sh. Please do
 # not use bashisms.
 #
+# Faster code for particular shells goes in "#@if <shell>..." blocks:
+# their "#@" lines are used in the variants the Makefile generates for
+# those shells, the "#@else" part everywhere else. See mkvariant.awk.
+#
+
+# Where our helper programs and modules live. The Makefile fills in the
+# installed path. Used from the source tree, functions.sh looks next to
+# itself if the shell tells where that is (bash), or in the current
+# directory. Not RC_LIBEXECDIR: OpenRC exports that as its own /lib/rc
+# to the scripts it runs, GENTOO_FUNCTIONS_LIBEXECDIR overrides it.
+#@if bash
+#@# The generic functions.sh that sourced us has found it already
+#@_E_LIBEXECDIR="${_E_LIBEXECDIR:-${GENTOO_FUNCTIONS_LIBEXECDIR:-@ROOTLIBEXECDIR@}}"
+#@else
+_E_LIBEXECDIR="${GENTOO_FUNCTIONS_LIBEXECDIR:-@ROOTLIBEXECDIR@}"
+#@endif
+case "${_E_LIBEXECDIR}" in
+	@*@)
+		case "${BASH_SOURCE:-}" in
+			*/*) _E_LIBEXECDIR="${BASH_SOURCE%/*}";;
+			*) _E_LIBEXECDIR="${PWD:-.}";;
+		esac
+		;;
+esac
+
+#@if bash
+#@else
+# Use the variant generated for bash when running in bash
+if [ -n "${BASH_VERSION}" ] && \
+	[ -r "${_E_LIBEXECDIR}/bash/functions.sh" ] ; then
+	. "${_E_LIBEXECDIR}/bash/functions.sh" "$@"
+	return
+fi
+#@endif
 
 RC_GOT_FUNCTIONS="yes"
 
 #
 #    hard set the indent used for e-commands.
 #    num defaults to 0
+#    The indent is adjusted in place by appending or stripping spaces,
+#    so no subshell is spawned.
 # This is a private function.
 #
 _esetdent()
 {
 	local i="$1"
 	[ -z "$i" ] || [ "$i" -lt 0 ] && i=0
-	RC_INDENTATION=$(printf "%${i}s" '')
+
+	#@if bash
+	#@while [ "${#_RC_SPACES}" -lt "$i" ]; do
+	#@	_RC_SPACES="${_RC_SPACES:- }${_RC_SPACES}"
+	#@done
+	#@RC_INDENTATION="${_RC_SPACES:0:i}"
+	#@else
+	[ "$i" -eq 0 ] && RC_INDENTATION=''
+
+	while [ "${#RC_INDENTATION}" -lt "$i" ]; do
+		RC_INDENTATION="${RC_INDENTATION} "
+	done
+	while [ "${#RC_INDENTATION}" -gt "$i" ]; do
+		RC_INDENTATION="${RC_INDENTATION%?}"
+	done
+	#@endif
 }
 
 #
@@ -63,229 +114,6 @@ yesno()
 	esac
 }
 
-#
-#    use the system logger to log a message
-#
-esyslog()
-{
-	local pri=
-	local tag=
-
-	if [ -n "$EINFO_LOG" ] && command -v logger > /dev/null 2>&1; then
-		pri="$1"
-		tag="$2"
-
-		shift 2
-		[ -z "$*" ] && return 0
-
-		logger -p "${pri}" -t "${tag}" -- "$*"
-	fi
-
-	return 0
-}
-
-#
-#    show an informative message (without a newline)
-#
-einfon()
-{
-	if yesno "${EINFO_QUIET}"; then
-		return 0
-	fi
-	if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
-		printf "\n"
-	fi
-	printf " ${GOOD}*${NORMAL} ${RC_INDENTATION}$*"
-	LAST_E_CMD="einfon"
-	return 0
-}
-
-#
-#    show an informative message (with a newline)
-#
-einfo()
-{
-	einfon "$*\n"
-	LAST_E_CMD="einfo"
-	return 0
-}
-
-#
-#    show a warning message (without a newline) and log it
-#
-ewarnn()
-{
-	if yesno "${EINFO_QUIET}"; then
-		return 0
-	else
-		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
-			printf "\n" >&2
-		fi
-		printf " ${WARN}*${NORMAL} ${RC_INDENTATION}$*" >&2
-	fi
-
-	local name="${0##*/}"
-	# Log warnings to system log
-	esyslog "daemon.warning" "${name}" "$*"
-
-	LAST_E_CMD="ewarnn"
-	return 0
-}
-
-#
-#    show a warning message (with a newline) and log it
-#
-ewarn()
-{
-	if yesno "${EINFO_QUIET}"; then
-		return 0
-	else
-		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
-			printf "\n" >&2
-		fi
-		printf " ${WARN}*${NORMAL} ${RC_INDENTATION}$*\n" >&2
-	fi
-
-	local name="${0##*/}"
-	# Log warnings to system log
-	esyslog "daemon.warning" "${name}" "$*"
-
-	LAST_E_CMD="ewarn"
-	return 0
-}
-
-#
-#    show an error message (without a newline) and log it
-#
-eerrorn()
-{
-	if yesno "${EERROR_QUIET}"; then
-		return 1
-	else
-		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
-			printf "\n" >&2
-		fi
-		printf " ${BAD}*${NORMAL} ${RC_INDENTATION}$*" >&2
-	fi
-
-	local name="${0##*/}"
-	# Log errors to system log
-	esyslog "daemon.err" "rc-scripts" "$*"
-
-	LAST_E_CMD="eerrorn"
-	return 1
-}
-
-#
-#    show an error message (with a newline) and log it
-#
-eerror()
-{
-	if yesno "${EERROR_QUIET}"; then
-		return 1
-	else
-		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
-			printf "\n" >&2
-		fi
-		printf " ${BAD}*${NORMAL} ${RC_INDENTATION}$*\n" >&2
-	fi
-
-	local name="${0##*/}"
-	# Log errors to system log
-	esyslog "daemon.err" "rc-scripts" "$*"
-
-	LAST_E_CMD="eerror"
-	return 1
-}
-
-#
-#    show a message indicating the start of a process
-#
-ebegin()
-{
-	local msg="$*"
-	if yesno "${EINFO_QUIET}"; then
-		return 0
-	fi
-
-	msg="${msg} ..."
-	einfon "${msg}"
-	if yesno "${RC_ENDCOL}"; then
-		printf "\n"
-	fi
-
-	LAST_E_LEN="$(( 3 + ${#RC_INDENTATION} + ${#msg} ))"
-	LAST_E_CMD="ebegin"
-	return 0
-}
-
-#
-#    indicate the completion of process, called from eend/ewend
-#    if error, show errstr via efunc
-#
-#    This function is private to functions.sh.  Do not call it from a
-#    script.
-#
-_eend()
-{
-	local retval="${1:-0}" efunc="${2:-eerror}" msg
-	shift 2
-
-	if [ "${retval}" = "0" ]; then
-		yesno "${EINFO_QUIET}" && return 0
-		msg="${BRACKET}[ ${GOOD}ok${BRACKET} ]${NORMAL}"
-	else
-		if [ -c /dev/null ] ; then
-			rc_splash "stop" >/dev/null 2>&1 &
-		else
-			rc_splash "stop" &
-		fi
-		if [ -n "$*" ] ; then
-			${efunc} "$*"
-		fi
-		msg="${BRACKET}[ ${BAD}!!${BRACKET} ]${NORMAL}"
-	fi
-
-	if yesno "${RC_ENDCOL}"; then
-		printf "${ENDCOL}  ${msg}\n"
-	else
-		[ "${LAST_E_CMD}" = ebegin ] || LAST_E_LEN=0
-		printf "%$(( COLS - LAST_E_LEN - 6 ))s%b\n" '' "${msg}"
-	fi
-
-	return ${retval}
-}
-
-#
-#    indicate the completion of process
-#    if error, show errstr via eerror
-#
-eend()
-{
-	local retval="${1:-0}"
-	[ $# -eq 0 ] || shift
-
-	_eend "${retval}" eerror "$*"
-
-	LAST_E_CMD="eend"
-	return ${retval}
-}
-
-#
-#    indicate the completion of process
-#    if error, show errstr via ewarn
-#
-ewend()
-{
-	local retval="${1:-0}"
-	[ $# -eq 0 ] || shift
-
-	_eend "${retval}" ewarn "$*"
-
-	LAST_E_CMD="ewend"
-	return ${retval}
-}
-
 # v-e-commands honor EINFO_VERBOSE which defaults to no.
 # The condition is negated so the return value will be zero.
 veinfo()
@@ -336,77 +164,47 @@ veoutdent()
 }
 
 #
-#    prints the current libdir {lib,lib32,lib64}
+#    source the named module from _E_MODDIR, once.
+#    return 1 if it is not installed
+# This is a private function.
 #
-get_libdir()
+_eload()
 {
-	if [ -n "${CONF_LIBDIR_OVERRIDE}" ] ; then
-		CONF_LIBDIR="${CONF_LIBDIR_OVERRIDE}"
-	elif command -v portageq > /dev/null 2>&1; then
-		CONF_LIBDIR="$(portageq envvar CONF_LIBDIR)"
+	case " ${_E_LOADED} " in
+		*" $1 "*) return 0;;
+	esac
+	if [ ! -r "${_E_MODDIR}/$1.sh" ] ; then
+		printf 'functions.sh: cannot load %s\n' "${_E_MODDIR}/$1.sh" >&2
+		return 1
 	fi
-	printf "${CONF_LIBDIR:=lib}\n"
-}
-
-#
-#   return 0 if gentoo=param was passed to the kernel
-#
-#   EXAMPLE:  if get_bootparam "nodevfs" ; then ....
-#
-get_bootparam()
-{
-	local x copt params retval=1
-
-	[ ! -r /proc/cmdline ] && return 1
-
-	read copts < /proc/cmdline
-	for copt in $copts ; do
-		if [ "${copt%=*}" = "gentoo" ] ; then
-			params=$(gawk -v PARAMS="${copt##*=}" '
-				BEGIN {
-					split(PARAMS, nodes, ",")
-					for (x in nodes)
-						print nodes[x]
-				}')
-
-			# Parse gentoo option
-			for x in ${params} ; do
-				if [ "${x}" = "$1" ] ; then
-#					echo "YES"
-					retval=0
-				fi
-			done
-		fi
-	done
-
-	return ${retval}
-}
-
-#
-#   return 0 if any of the files/dirs are newer than
-#   the reference file
-#
-#   EXAMPLE: if is_older_than a.out *.o ; then ...
-is_older_than()
-{
-	local x=
-	local ref="$1"
-	[ $# -eq 0 ] || shift
-
-	for x in "$@" ; do
-		[ "${x}" -nt "${ref}" ] && return 0
-		[ -d "${x}" ] && is_older_than "${ref}" "${x}"/* && return 0
-	done
-
-	return 1
+	_E_LOADED="${_E_LOADED} $1"
+	. "${_E_MODDIR}/$1.sh"
 }
 
 # This is the main script, please add all functions above this point!
 
+#@if bash
+#@_E_MODDIR="${_E_LIBEXECDIR}/@VARIANT@/functions"
+#@else
+_E_MODDIR="${_E_LIBEXECDIR}/functions"
+#@endif
+# Remember what answered earlier is_older_than queries?
+RC_OLDER_THAN_CACHE="${RC_OLDER_THAN_CACHE:-no}"
+
 # Dont output to stdout?
 EINFO_QUIET="${EINFO_QUIET:-no}"
 EINFO_VERBOSE="${EINFO_VERBOSE:-no}"
 
+# Show how long each ebegin/eend span took?
+EINFO_TIMING="${EINFO_TIMING:-no}"
+# Record every span in EINFO_BLAME_FILE for eblame?
+EINFO_BLAME="${EINFO_BLAME:-no}"
+
+# Messages shown so far, per level
+EINFO_COUNT_INFO=0
+EINFO_COUNT_WARN=0
+EINFO_COUNT_ERROR=0
+
 # Should we use color?
 RC_NOCOLOR="${RC_NOCOLOR:-no}"
 # Can the terminal handle endcols?
@@ -417,16 +215,14 @@ RC_INDENTATION=''
 RC_DEFAULT_INDENT=2
 RC_DOT_PATTERN=''
 
-# Cache the CONSOLETYPE - this is important as backgrounded shells don't
-# have a TTY. rc unsets it at the end of running so it shouldn't hang
-# around
-if [ -z "${CONSOLETYPE}" ] ; then
-	CONSOLETYPE="$(consoletype stdout 2>/dev/null )"; export CONSOLETYPE
-fi
-if [ "${CONSOLETYPE}" = "serial" ] ; then
-	RC_NOCOLOR="yes"
-	RC_ENDCOL="no"
-fi
+# Characters that need escaping in NDJSON records, see _ejson
+_E_NL='
+'
+_E_TAB='	'
+
+# Where e-output goes, see _enonblock
+_E_OUT="${_E_OUT:-1}"
+_E_ERR="${_E_ERR:-2}"
 
 for arg in "$@" ; do
 	case "${arg}" in
@@ -437,36 +233,44 @@ for arg in "$@" ; do
 	esac
 done
 
-# Setup COLS and ENDCOL so eend can line up the [ ok ]
-COLS="${COLUMNS:-0}"            # bash's internal COLUMNS variable
-[ "$COLS" -eq 0 ] && \
-        COLS="$(set -- $(stty size 2>/dev/null) ; printf "$2\n")"
-[ -z "$COLS" ] && COLS=80
-[ "$COLS" -gt 0 ] || COLS=80	# width of [ ok ] == 7
-
-if yesno "${RC_ENDCOL}"; then
-	ENDCOL='\033[A\033['$(( COLS - 8 ))'C'
-else
-	ENDCOL=''
+# Everything else lives in modules, loaded by these stubs the first
+# time one of their functions is called
+for _e_fn in esyslog einfon einfo ewarnn ewarn eerrorn eerror ebegin \
+	eend ewend einfo_stream ewarn_stream eerror_stream esummary ; do
+	eval "${_e_fn}() { _eload output && ${_e_fn} \"\$@\"; }"
+done
+for _e_fn in get_libdir ; do
+	eval "${_e_fn}() { _eload libdir && ${_e_fn} \"\$@\"; }"
+done
+for _e_fn in get_bootparam get_bootparam_value ; do
+	eval "${_e_fn}() { _eload bootparam && ${_e_fn} \"\$@\"; }"
+done
+for _e_fn in is_older_than ; do
+	eval "${_e_fn}() { _eload fs && ${_e_fn} \"\$@\"; }"
+done
+for _e_fn in eparallel ; do
+	eval "${_e_fn}() { _eload parallel && ${_e_fn} \"\$@\"; }"
+done
+for _e_fn in eboard_start eboard_set eboard_del eboard_draw eboard_clear \
+	eboard_stop ; do
+	eval "${_e_fn}() { _eload board && ${_e_fn} \"\$@\"; }"
+done
+for _e_fn in eprogress_start eprogress_update eprogress_finish ; do
+	eval "${_e_fn}() { _eload progress && ${_e_fn} \"\$@\"; }"
+done
+unset _e_fn
+
+# List the slowest and the failed spans on exit if asked to. A script
+# that sets an EXIT trap of its own replaces this one, and should call
+# esummary from it.
+if [ -n "${EINFO_SUMMARY}" ]; then
+	trap 'esummary' EXIT
 fi
 
-# Setup the colors so our messages all look pretty
-if yesno "${RC_NOCOLOR}"; then
-	unset GOOD WARN BAD NORMAL HILITE BRACKET
-elif (command -v tput && tput colors) >/dev/null 2>&1; then
-	GOOD="$(tput sgr0)$(tput bold)$(tput setaf 2)"
-	WARN="$(tput sgr0)$(tput bold)$(tput setaf 3)"
-	BAD="$(tput sgr0)$(tput bold)$(tput setaf 1)"
-	HILITE="$(tput sgr0)$(tput bold)$(tput setaf 6)"
-	BRACKET="$(tput sgr0)$(tput bold)$(tput setaf 4)"
-	NORMAL="$(tput sgr0)"
-else
-	GOOD=$(printf '\033[32;01m')
-	WARN=$(printf '\033[33;01m')
-	BAD=$(printf '\033[31;01m')
-	HILITE=$(printf '\033[36;01m')
-	BRACKET=$(printf '\033[34;01m')
-	NORMAL=$(printf '\033[0m')
+# Set up the terminal now, unless asked to wait for the first message.
+# Scripts doing so must not use GOOD, BAD, COLS and friends before.
+if ! yesno "${RC_DEFER_TERM:-no}" ; then
+	_eload term
 fi
 
 # If we made it this far, the script succeeded, so don't let failures
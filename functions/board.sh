@@ -0,0 +1,196 @@
+# Copyright 2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# A live status board: one line per active job, kept below the
+# messages and redrawn in place.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+# The board needs the terminal set up and the message helpers
+_eload output
+
+#
+#    cut a string to at most $2 characters, result in _E_TRUNC.
+# This is a private function.
+#
+_etrunc()
+{
+	local s="$1" w="$2"
+
+	[ "${w}" -gt 0 ] || w=0
+	#@if bash
+	#@_E_TRUNC="${s:0:w}"
+	#@else
+	while [ "${#s}" -gt $(( w + 8 )) ]; do
+		s="${s%????????}"
+	done
+	while [ "${#s}" -gt "${w}" ]; do
+		s="${s%?}"
+	done
+	_E_TRUNC="${s}"
+	#@endif
+}
+
+#
+#    start a board. On a vt or pty the board is drawn below the cursor
+#    and redrawn in place; on serial consoles, when stdout is not a
+#    terminal or without ENDCOL, changed lines are printed as plain
+#    lines instead.
+#
+eboard_start()
+{
+	_E_BOARD=''
+	_E_BOARD_SHOWN=''
+	_E_BOARD_ROWS=0
+	_E_BOARD_LAST=''
+	if [ -t 1 ] && [ "${CONSOLETYPE}" != "serial" ] && yesno "${RC_ENDCOL}"; then
+		_E_BOARD_TTY="yes"
+	else
+		_E_BOARD_TTY="no"
+	fi
+	return 0
+}
+
+#
+#    set the line for key $1 to $2, adding it at the bottom if new.
+#    Shown by the next eboard_draw.
+#
+eboard_set()
+{
+	local pre after
+
+	pre="${_E_BOARD%%"${_E_NL}$1${_E_TAB}"*}"
+	if [ "${pre}" = "${_E_BOARD}" ]; then
+		_E_BOARD="${_E_BOARD}${_E_NL}$1${_E_TAB}$2"
+		return 0
+	fi
+	after="${_E_BOARD#*"${_E_NL}$1${_E_TAB}"}"
+	case "${after}" in
+		*"${_E_NL}"*) after="${_E_NL}${after#*"${_E_NL}"}";;
+		*) after='';;
+	esac
+	_E_BOARD="${pre}${_E_NL}$1${_E_TAB}$2${after}"
+}
+
+#
+#    remove the line for key $1. Gone after the next eboard_draw.
+#
+eboard_del()
+{
+	local pre after
+
+	pre="${_E_BOARD%%"${_E_NL}$1${_E_TAB}"*}"
+	[ "${pre}" = "${_E_BOARD}" ] && return 0
+	after="${_E_BOARD#*"${_E_NL}$1${_E_TAB}"}"
+	case "${after}" in
+		*"${_E_NL}"*) after="${_E_NL}${after#*"${_E_NL}"}";;
+		*) after='';;
+	esac
+	_E_BOARD="${pre}${after}"
+}
+
+#
+#    bring the board on screen up to date, with a single write. Only
+#    lines that changed are redrawn, and at most EINFO_BOARD_FPS times
+#    a second (10 by default), unless -f is given.
+#
+eboard_draw()
+{
+	local fps="${EINFO_BOARD_FPS:-10}" board shown line old out=''
+	local n=0 i=0 width
+
+	if [ "$1" != "-f" ] && [ -n "${_E_BOARD_LAST}" ] && _eclock; then
+		[ "${fps}" -gt 0 ] 2>/dev/null || fps=10
+		[ $(( _E_CLOCK - _E_BOARD_LAST )) -lt $(( 1000 / fps )) ] && \
+			return 0
+	fi
+	_eclock
+	_E_BOARD_LAST="${_E_CLOCK:-0}"
+
+	# Format the lines, cut to fit so none of them wraps
+	width=$(( COLS - 4 - ${#RC_INDENTATION} - 1 ))
+	board="${_E_BOARD}${_E_NL}"
+	_E_BOARD_NEW=''
+	while [ -n "${board#"${_E_NL}"}" ]; do
+		board="${board#"${_E_NL}"}"
+		line="${board%%"${_E_NL}"*}"
+		board="${board#*"${_E_NL}"}"
+		_etrunc "${line#*"${_E_TAB}"}" "${width}"
+		_E_BOARD_NEW="${_E_BOARD_NEW}${_E_NL}${line%%"${_E_TAB}"*}${_E_TAB} ${HILITE}*${NORMAL} ${RC_INDENTATION}${_E_TRUNC}"
+		n=$(( n + 1 ))
+	done
+	board="${_E_BOARD_NEW}${_E_NL}"
+	_ectl
+
+	if [ "${_E_BOARD_TTY}" != "yes" ]; then
+		# Print the lines that are new or changed
+		while [ -n "${board#"${_E_NL}"}" ]; do
+			board="${board#"${_E_NL}"}"
+			line="${board%%"${_E_NL}"*}"
+			board="${board#*"${_E_NL}"}"
+			case "${_E_BOARD_SHOWN}${_E_NL}" in
+				*"${_E_NL}${line}${_E_NL}"*) ;;
+				*) out="${out}${line#*"${_E_TAB}"}${_E_NL}";;
+			esac
+		done
+	elif [ "${n}" -ne "${_E_BOARD_ROWS}" ]; then
+		# Lines came or went, draw it all again
+		[ "${_E_BOARD_ROWS}" -gt 0 ] && \
+			out="${_E_ESC}[${_E_BOARD_ROWS}A${_E_CR}${_E_ESC}[J"
+		while [ -n "${board#"${_E_NL}"}" ]; do
+			board="${board#"${_E_NL}"}"
+			line="${board%%"${_E_NL}"*}"
+			board="${board#*"${_E_NL}"}"
+			out="${out}${line#*"${_E_TAB}"}${_E_NL}"
+		done
+	else
+		# Rewrite just the lines that changed, from the bottom up
+		shown="${_E_BOARD_SHOWN}${_E_NL}"
+		while [ -n "${board#"${_E_NL}"}" ]; do
+			board="${board#"${_E_NL}"}"
+			line="${board%%"${_E_NL}"*}"
+			board="${board#*"${_E_NL}"}"
+			shown="${shown#"${_E_NL}"}"
+			old="${shown%%"${_E_NL}"*}"
+			shown="${shown#*"${_E_NL}"}"
+			if [ "${line#*"${_E_TAB}"}" != "${old#*"${_E_TAB}"}" ]; then
+				out="${out}${_E_ESC}[$(( n - i ))A${_E_CR}${line#*"${_E_TAB}"}${_E_ESC}[K${_E_ESC}[$(( n - i ))B${_E_CR}"
+			fi
+			i=$(( i + 1 ))
+		done
+	fi
+
+	_E_BOARD_SHOWN="${_E_BOARD_NEW}"
+	[ "${_E_BOARD_TTY}" = "yes" ] && _E_BOARD_ROWS="${n}"
+	[ -z "${out}" ] || _eout '%s' "${out}"
+}
+
+#
+#    take the board off the screen, so that messages can be printed.
+#    The next eboard_draw puts it back.
+#
+eboard_clear()
+{
+	[ "${_E_BOARD_TTY}" = "yes" ] || return 0
+	[ "${_E_BOARD_ROWS}" -gt 0 ] && \
+		_eout '\033[%dA\r\033[J' "${_E_BOARD_ROWS}"
+	_E_BOARD_ROWS=0
+	_E_BOARD_SHOWN=''
+	_E_BOARD_LAST=''
+}
+
+#
+#    remove the board.
+#
+eboard_stop()
+{
+	eboard_clear
+	_E_BOARD=''
+	_E_BOARD_SHOWN=''
+	return 0
+}
+
+# vim:ts=4
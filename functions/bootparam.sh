@@ -0,0 +1,95 @@
+# Copyright 1999-2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# get_bootparam, get_bootparam_value and their helpers.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+#
+#    read /proc/cmdline once per shell: the whole line goes into
+#    _E_CMDLINE as " a b=c ", the gentoo= options into _E_GENTOO_OPTS
+#    as ",x,y,", so lookups are plain pattern matches.
+# This is a private function.
+#
+_ecmdline()
+{
+	local copt copts
+
+	[ -n "${_E_CMDLINE}" ] && return 0
+	[ ! -r /proc/cmdline ] && return 1
+
+	read -r copts < /proc/cmdline
+	_E_CMDLINE=" ${copts} "
+	_E_GENTOO_OPTS=","
+	for copt in ${copts} ; do
+		case "${copt}" in
+			gentoo=*) _E_GENTOO_OPTS="${_E_GENTOO_OPTS}${copt#gentoo=},";;
+		esac
+	done
+	return 0
+}
+
+#
+#   return 0 if gentoo=param was passed to the kernel, for every
+#   param given
+#
+#   EXAMPLE:  if get_bootparam "nodevfs" ; then ....
+#
+get_bootparam()
+{
+	local x
+
+	_ecmdline || return 1
+	[ $# -eq 0 ] && return 1
+
+	for x in "$@" ; do
+		case "${_E_GENTOO_OPTS}" in
+			*,"${x:-,}",*) ;;
+			*) return 1;;
+		esac
+	done
+	return 0
+}
+
+#
+#   store the value of each name=value kernel parameter in the variable
+#   named after it, the last one passed wins. Variables for parameters
+#   that were not passed are emptied.
+#   return 0 if all of the parameters were passed to the kernel
+#
+#   EXAMPLE:  get_bootparam_value root rootdev init initpath
+#
+get_bootparam_value()
+{
+	local _e_name _e_var _e_value _e_retval=0
+
+	_ecmdline || return 1
+
+	while [ $# -ge 2 ] ; do
+		_e_name="$1"
+		_e_var="$2"
+		shift 2
+		case "${_e_var}" in
+			''|[0-9]*|*[!A-Za-z0-9_]*) return 1;;
+		esac
+
+		case "${_E_CMDLINE}" in
+			*" ${_e_name}="*)
+				_e_value="${_E_CMDLINE##*" ${_e_name}="}"
+				_e_value="${_e_value%% *}"
+				;;
+			*)
+				_e_value=
+				_e_retval=1
+				;;
+		esac
+		eval "${_e_var}=\${_e_value}"
+	done
+
+	return ${_e_retval}
+}
+
+# vim:ts=4
@@ -0,0 +1,121 @@
+# Copyright 1999-2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Filesystem helpers: is_older_than.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+#
+#    walk the trees in shell for is_older_than when the newer-than
+#    helper is not installed. The newer file found is left in
+#    _E_WITNESS.
+# This is a private function.
+#
+_eis_older_than()
+{
+	local x=
+	local ref="$1"
+	[ $# -eq 0 ] || shift
+
+	for x in "$@" ; do
+		if [ "${x}" -nt "${ref}" ] ; then
+			_E_WITNESS="${x}"
+			return 0
+		fi
+		[ -d "${x}" ] && _eis_older_than "${ref}" "${x}"/* && return 0
+	done
+
+	return 1
+}
+
+#
+#    is_older_than, remembering for each query the newer file that
+#    answered it. While that file is still newer than the reference
+#    the query is answered by a single test, without walking anything.
+#    Queries that found nothing newer are not remembered, as a file
+#    changed in place does not touch the mtime of its directory.
+# This is a private function.
+#
+_eis_older_than_cached()
+{
+	local key ref="$1" x witness
+
+	[ $# -gt 0 ] || return 1
+	# Keys are the arguments joined by tabs, skip those we cannot join
+	for x in "$@" ; do
+		case "${x}" in
+			''|*"${_E_TAB}"*|*"${_E_NL}"*) _eis_older_than "$@"; return;;
+		esac
+	done
+	key="${_E_NL}${ref}"
+	shift
+	for x in "$@" ; do
+		key="${key}${_E_TAB}${x}"
+	done
+	key="${key}${_E_TAB}${_E_TAB}"
+
+	case "${_E_OLDER_CACHE}" in
+		*"${key}"*)
+			witness="${_E_OLDER_CACHE#*"${key}"}"
+			witness="${witness%%"${_E_NL}"*}"
+			[ "${witness}" -nt "${ref}" ] && return 0
+			_E_OLDER_CACHE="${_E_OLDER_CACHE%%"${key}"*}${_E_OLDER_CACHE#*"${key}${witness}"}"
+			;;
+	esac
+
+	if [ -x "${_E_LIBEXECDIR}/newer-than" ] ; then
+		witness="$("${_E_LIBEXECDIR}/newer-than" -p -- "${ref}" "$@")"
+		case $? in
+			0) ;;
+			1) return 1;;
+			*) _eis_older_than "${ref}" "$@" || return 1
+			   witness="${_E_WITNESS}";;
+		esac
+	else
+		_eis_older_than "${ref}" "$@" || return 1
+		witness="${_E_WITNESS}"
+	fi
+
+	[ -n "${witness}" ] && _E_OLDER_CACHE="${_E_OLDER_CACHE}${key}${witness}"
+	return 0
+}
+
+#
+#   return 0 if any of the files/dirs are newer than
+#   the reference file
+#
+#   EXAMPLE: if is_older_than a.out *.o ; then ...
+is_older_than()
+{
+	local x
+
+	# Without the reference everything is newer, as bash's -nt and the
+	# helper have it, but not dash's -nt
+	if [ $# -gt 0 ] && [ ! -e "$1" ] ; then
+		shift
+		for x in "$@" ; do
+			[ -e "${x}" ] && return 0
+		done
+		return 1
+	fi
+
+	if yesno "${RC_OLDER_THAN_CACHE}" ; then
+		_eis_older_than_cached "$@"
+		return
+	fi
+
+	if [ -x "${_E_LIBEXECDIR}/newer-than" ] ; then
+		"${_E_LIBEXECDIR}/newer-than" -- "$@"
+		case $? in
+			0) return 0;;
+			1) return 1;;
+		esac
+	fi
+
+	_eis_older_than "$@"
+}
+
+# vim:ts=4
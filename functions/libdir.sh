@@ -0,0 +1,170 @@
+# Copyright 1999-2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# get_libdir and its helpers.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+#
+#    read the CONF_LIBDIR, DEFAULT_ABI and LIBDIR_* assignments of the
+#    given make.defaults or make.conf files into _E_CONF_<name>.
+#    Only plain values are understood, references to other variables
+#    are not expanded. The files are added to _E_CONF_FILES.
+# This is a private function.
+#
+_econf_read()
+{
+	local f line name value
+
+	for f in "$@" ; do
+		[ -f "${f}" ] || continue
+		_E_CONF_FILES="${_E_CONF_FILES}${_E_NL}${f}"
+		while IFS= read -r line || [ -n "${line}" ] ; do
+			line="${line#"${line%%[! 	]*}"}"
+			line="${line#export }"
+			case "${line}" in
+				CONF_LIBDIR=*|DEFAULT_ABI=*|LIBDIR_*=*) ;;
+				*) continue;;
+			esac
+			name="${line%%=*}"
+			value="${line#*=}"
+			case "${name}" in
+				*[!A-Za-z0-9_]*) continue;;
+			esac
+			case "${value}" in
+				\"*) value="${value#?}"; value="${value%%\"*}";;
+				\'*) value="${value#?}"; value="${value%%\'*}";;
+				*) value="${value%%[ 	#]*}";;
+			esac
+			eval "_E_CONF_${name}=\${value}"
+		done < "${f}"
+	done
+}
+
+#
+#    read the make.defaults of a profile, after those of its parents.
+#    The directories and parent files are added to _E_CONF_FILES, so
+#    that files appearing in them are noticed too.
+# This is a private function.
+#
+_econf_profile()
+{
+	local dir="$1" parent
+
+	[ -d "${dir}" ] || return 0
+	_E_CONF_FILES="${_E_CONF_FILES}${_E_NL}${dir}"
+	if [ -f "${dir}/parent" ] ; then
+		_E_CONF_FILES="${_E_CONF_FILES}${_E_NL}${dir}/parent"
+		while read -r parent || [ -n "${parent}" ] ; do
+			case "${parent}" in
+				''|'#'*|*:*) continue;;
+				/*) ;;
+				*) parent="${dir}/${parent}";;
+			esac
+			_econf_profile "${parent}"
+		done < "${dir}/parent"
+	fi
+	_econf_read "${dir}/make.defaults"
+}
+
+#
+#    work out CONF_LIBDIR the way portage does, from CONF_LIBDIR or
+#    from LIBDIR_${DEFAULT_ABI} in the profile and make.conf, without
+#    starting portage.
+# This is a private function.
+#
+_elibdir_resolve()
+{
+	local etc="${PORTAGE_CONFIGROOT%/}/etc/portage" abi
+
+	_E_CONF_FILES=
+	[ -d "${etc}/make.profile" ] || return 1
+
+	_E_CONF_CONF_LIBDIR=
+	_E_CONF_DEFAULT_ABI=
+	_econf_profile "${etc}/make.profile"
+	_econf_profile "${etc}/profile"
+	if [ -d "${etc}/make.conf" ] ; then
+		_econf_read "${etc}/make.conf"/*
+	else
+		_econf_read "${etc}/make.conf"
+	fi
+
+	CONF_LIBDIR="${_E_CONF_CONF_LIBDIR}"
+	if [ -z "${CONF_LIBDIR}" ] ; then
+		abi="${_E_CONF_DEFAULT_ABI}"
+		case "${abi}" in
+			''|*[!A-Za-z0-9_]*) return 1;;
+		esac
+		eval "CONF_LIBDIR=\${_E_CONF_LIBDIR_${abi}}"
+	fi
+	[ -n "${CONF_LIBDIR}" ]
+}
+
+#
+#    return 0 if the get_libdir cache file is newer than everything
+#    that can change the answer: what is in /etc/portage, and the
+#    profiles, their parents and the files read from them, which the
+#    cache lists after the libdir.
+# This is a private function.
+#
+_elibdir_fresh()
+{
+	local cache="$1" f
+
+	[ -f "${cache}" ] || return 1
+	for f in /etc/portage /etc/portage/make.conf /etc/portage/make.conf/* \
+		/etc/portage/make.profile /etc/portage/profile ; do
+		[ "${f}" -nt "${cache}" ] && return 1
+	done
+	{
+		read -r f
+		while IFS= read -r f ; do
+			[ -z "${f}" ] || [ ! "${f}" -nt "${cache}" ] || return 1
+		done
+	} < "${cache}"
+	return 0
+}
+
+#
+#    prints the current libdir {lib,lib32,lib64}
+#    The answer is kept for the lifetime of the shell, and across
+#    shells in RC_LIBDIR_CACHE until the portage configuration changes.
+#
+get_libdir()
+{
+	local cache="${RC_LIBDIR_CACHE:-/run/gentoo-functions/libdir}"
+
+	if [ -n "${CONF_LIBDIR_OVERRIDE}" ] ; then
+		CONF_LIBDIR="${CONF_LIBDIR_OVERRIDE}"
+	elif [ -n "${_E_LIBDIR}" ] ; then
+		CONF_LIBDIR="${_E_LIBDIR}"
+	else
+		# The cache is only valid for the default configuration root
+		[ -z "${PORTAGE_CONFIGROOT}" ] || cache=
+
+		if [ -n "${cache}" ] && _elibdir_fresh "${cache}" ; then
+			read -r CONF_LIBDIR < "${cache}"
+			cache=
+		elif _elibdir_resolve ; then
+			:
+		elif command -v portageq > /dev/null 2>&1; then
+			CONF_LIBDIR="$(portageq envvar CONF_LIBDIR)"
+			_E_CONF_FILES=
+		fi
+		: "${CONF_LIBDIR:=lib}"
+
+		if [ -n "${cache}" ] ; then
+			{ [ -d "${cache%/*}" ] || mkdir -p "${cache%/*}" ; } 2>/dev/null && \
+				printf '%s%s\n' "${CONF_LIBDIR}" "${_E_CONF_FILES}" \
+					2>/dev/null > "${cache}"
+		fi
+		_E_LIBDIR="${CONF_LIBDIR}"
+	fi
+	printf "${CONF_LIBDIR:=lib}\n"
+}
+
+# vim:ts=4
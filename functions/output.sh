@@ -0,0 +1,998 @@
+# Copyright 1999-2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# The e-message output functions.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+# Messages need the terminal set up
+_eload term
+
+#
+#    find a file descriptor that is not open into _E_FD: the one given,
+#    or the highest free one the shell can name, away from the ones
+#    scripts usually pick. An open one is never taken over.
+# This is a private function.
+#
+_efreefd()
+{
+	local fd
+
+	for fd in ${1:-9 8 7 6 5 4 3}; do
+		if ! { true >&"${fd}"; } 2>/dev/null; then
+			_E_FD="${fd}"
+			return 0
+		fi
+	done
+	return 1
+}
+
+#
+#    printf the rest of the arguments into the helper FIFO on fd $1,
+#    which does not block. Fails if the helper cannot keep up or is
+#    gone. The fd is open for reading too, so there is always a reader
+#    and no SIGPIPE, which would kill the script: a helper that is gone
+#    shows once the FIFO is full.
+# This is a private function.
+#
+_efifo()
+{
+	local fd="$1"
+	shift
+
+	printf "$@" 2>/dev/null >&"${fd}"
+}
+
+#
+#    printf the arguments to the e-output, _E_OUT. Through econsole the
+#    write does not block, and if it fails the output goes back to
+#    stdout and stderr for the rest of the script.
+# This is a private function.
+#
+_eout()
+{
+	if [ -z "${_E_NONBLOCK_FD}" ]; then
+		printf "$@" >&"${_E_OUT}"
+		return
+	fi
+	_efifo "${_E_NONBLOCK_FD}" "$@" && return 0
+	_enonblock_stop
+	printf "$@"
+}
+
+#
+#    the same for warnings and errors, which go to _E_ERR.
+# This is a private function.
+#
+_eerr()
+{
+	if [ -z "${_E_NONBLOCK_ERR_FD}" ]; then
+		printf "$@" >&"${_E_ERR}"
+		return
+	fi
+	_efifo "${_E_NONBLOCK_ERR_FD}" "$@" && return 0
+	_enonblock_stop
+	printf "$@" >&2
+}
+
+#
+#    start an econsole helper writing to fd $1 of ours. It reads a FIFO
+#    named after $3 that we hold open twice: read-write on the fd given
+#    as $2 or a free one from 9 down, made non-blocking by the helper,
+#    into _E_NB for our own output, and write-only on another one into
+#    _E_FD for the commands we run, which may wait for it. Returns 1 if it cannot
+#    be set up.
+# This is a private function.
+#
+_econsole()
+{
+	local dir="${EINFO_NONBLOCK_DIR:-/run/gentoo-functions}" fifo nb
+
+	_efreefd "$2" || return 1
+	nb="${_E_FD}"
+	fifo="${dir}/console-$3.$$"
+	[ -d "${dir}" ] || mkdir -p "${dir}" 2>/dev/null
+	mkfifo -m 0600 "${fifo}" 2>/dev/null || return 1
+
+	# Held read-write, see _efifo, which also keeps the open of the
+	# write-only end from waiting for the helper
+	eval "exec ${nb}<>\"\${fifo}\""
+	if ! _efreefd; then
+		eval "exec ${nb}>&-"
+		rm -f "${fifo}"
+		return 1
+	fi
+	eval "exec ${_E_FD}>\"\${fifo}\""
+
+	# It goes into the background once it reads the FIFO, and removes it
+	if ! "${_E_LIBEXECDIR}/econsole" -b "${EINFO_NONBLOCK_BACKLOG:-65536}" \
+		-p "$$" -w "${nb}" "${fifo}" </dev/null >&"$1"; then
+		eval "exec ${nb}>&- ${_E_FD}>&-"
+		rm -f "${fifo}"
+		return 1
+	fi
+	_E_NB="${nb}"
+}
+
+#
+#    send e-output through econsole helpers, which write it to the
+#    console without blocking and keep a bounded backlog, dropping and
+#    counting messages beyond it. Messages go out on _E_NONBLOCK_FD,
+#    EINFO_NONBLOCK_FD if set, and warnings and errors on
+#    _E_NONBLOCK_ERR_FD. _E_OUT and _E_ERR become the ends the commands
+#    we run write to. Where stdout and stderr are the same, one helper
+#    serves both and keeps the messages in order. Returns 1, leaving the
+#    output alone, if it cannot be set up.
+# This is a private function.
+#
+_enonblock()
+{
+	[ -x "${_E_LIBEXECDIR}/econsole" ] || return 1
+	_econsole 1 "${EINFO_NONBLOCK_FD}" out || return 1
+	_E_NONBLOCK_FD="${_E_NB}"
+	_E_OUT="${_E_FD}"
+
+	if [ /dev/stdout -ef /dev/stderr ]; then
+		_E_NONBLOCK_ERR_FD="${_E_NONBLOCK_FD}"
+		_E_ERR="${_E_OUT}"
+	elif _econsole 2 '' err; then
+		_E_NONBLOCK_ERR_FD="${_E_NB}"
+		_E_ERR="${_E_FD}"
+	fi
+	return 0
+}
+
+#
+#    stop writing through econsole, after a write failed: the helper is
+#    gone or stuck. Output goes to stdout and stderr again.
+# This is a private function.
+#
+_enonblock_stop()
+{
+	[ -z "${_E_NONBLOCK_FD}" ] || \
+		eval "exec ${_E_NONBLOCK_FD}>&- ${_E_OUT}>&-"
+	[ -z "${_E_NONBLOCK_ERR_FD}" ] || \
+		eval "exec ${_E_NONBLOCK_ERR_FD}>&- ${_E_ERR}>&-"
+	_E_NONBLOCK_FD=''
+	_E_NONBLOCK_ERR_FD=''
+	_E_OUT=1
+	_E_ERR=2
+}
+
+#
+#    send esyslog records to the journal through the ejournal helper,
+#    which batches them into native protocol datagrams with their fields
+#    kept apart. The helper reads a FIFO in EINFO_NONBLOCK_DIR that we
+#    hold read-write and non-blocking on EINFO_JOURNAL_FD, a free one
+#    from 9 down by default. Returns 1 if it cannot be set up, and stays
+#    off for the rest of the script then.
+# This is a private function.
+#
+_ejournal()
+{
+	local dir="${EINFO_NONBLOCK_DIR:-/run/gentoo-functions}" fifo fd
+
+	case "${_E_JOURNAL_FD}" in
+		'') ;;
+		none) return 1;;
+		*) return 0;;
+	esac
+	_E_JOURNAL_FD=none
+
+	[ -x "${_E_LIBEXECDIR}/ejournal" ] || return 1
+	_efreefd "${EINFO_JOURNAL_FD}" || return 1
+	fd="${_E_FD}"
+	fifo="${dir}/journal.$$"
+	[ -d "${dir}" ] || mkdir -p "${dir}" 2>/dev/null
+	mkfifo -m 0600 "${fifo}" 2>/dev/null || return 1
+
+	# Held read-write, as for econsole
+	eval "exec ${fd}<>\"\${fifo}\""
+	if ! "${_E_LIBEXECDIR}/ejournal" -p "$$" -w "${fd}" \
+		-s "${EINFO_JOURNAL_SOCKET:-/run/systemd/journal/socket}" \
+		"${fifo}" </dev/null >/dev/null 2>&1; then
+		eval "exec ${fd}>&-"
+		rm -f "${fifo}"
+		return 1
+	fi
+	_E_JOURNAL_FD="${fd}"
+}
+
+#
+#    use the system logger to log a message, or the journal if
+#    EINFO_JOURNAL is set. The function named in _E_EFUNC is logged with
+#    it there.
+#
+esyslog()
+{
+	local pri=
+	local tag=
+	local func="${_E_EFUNC:-esyslog}"
+
+	_E_EFUNC=''
+	[ -n "$EINFO_LOG" ] || return 0
+
+	pri="$1"
+	tag="$2"
+
+	shift 2
+	[ -z "$*" ] && return 0
+
+	if yesno "${EINFO_JOURNAL:-no}" && _ejournal; then
+		_ectl
+		_ejson_escape "$*"
+		_efifo "${_E_JOURNAL_FD}" '%s\t%s\t%s\t%s\t%s\t%s\t%s\n' \
+			"${pri}" "${tag}" "$$" "${0##*/}" "${func}" \
+			"${#RC_INDENTATION}" "${_E_JSON}" && return 0
+		# ejournal is gone or stuck, logger takes over
+		eval "exec ${_E_JOURNAL_FD}>&-"
+		_E_JOURNAL_FD=none
+	fi
+	if command -v logger > /dev/null 2>&1; then
+		logger -p "${pri}" -t "${tag}" -- "$*"
+	fi
+
+	return 0
+}
+
+#
+#    get a monotonic timestamp in milliseconds into _E_CLOCK without
+#    forking, using /proc/uptime or bash's EPOCHREALTIME.
+#    _E_CLOCK is left empty if neither is available.
+# This is a private function.
+#
+_eclock()
+{
+	local t= rest frac
+
+	[ -r /proc/uptime ] && read t rest < /proc/uptime
+	: "${t:=${EPOCHREALTIME}}"
+	if [ -z "${t}" ]; then
+		_E_CLOCK=''
+		return 1
+	fi
+
+	frac="${t#*[.,]}000"
+	frac="${frac%"${frac#???}"}"
+	_E_CLOCK=$(( ${t%%[.,]*} * 1000 + 1${frac} - 1000 ))
+}
+
+#
+#    set up _E_ESC, _E_CR and _E_CTL, all control characters from \001
+#    to \037 in order, which cannot be written portably in the source.
+#    Done on first use to keep the fork out of sourcing.
+# This is a private function.
+#
+_ectl()
+{
+	[ -z "${_E_CR}" ] || return 0
+	_E_CTL="$(printf '\001\002\003\004\005\006\007\010\011\012\013\014\015\016\017\020\021\022\023\024\025\026\027\030\031\032\033\034\035\036\037')"
+	_E_CR="${_E_CTL#????????????}"
+	_E_ESC="${_E_CR#??????????????}"
+	_E_CR="${_E_CR%"${_E_CR#?}"}"
+	_E_ESC="${_E_ESC%"${_E_ESC#?}"}"
+}
+
+#
+#    remove our colour sequences from a string, result in _E_PLAIN.
+# This is a private function.
+#
+_enocolor()
+{
+	local s="$1" c
+
+	# NORMAL is a prefix of the others, so it has to go last
+	for c in "${GOOD}" "${WARN}" "${BAD}" "${HILITE}" "${BRACKET}" "${NORMAL}"; do
+		[ -n "${c}" ] || continue
+		#@if bash
+		#@s="${s//"${c}"/}"
+		#@else
+		while :; do
+			case "${s}" in
+				*"${c}"*) s="${s%%"${c}"*}${s#*"${c}"}";;
+				*) break;;
+			esac
+		done
+		#@endif
+	done
+	_E_PLAIN="${s}"
+}
+
+#
+#    escape a string for use inside a JSON string, result in _E_JSON.
+#    Control characters without a short escape become \u00XX.
+# This is a private function.
+#
+_ejson_escape()
+{
+	local s="$1" pre c n lo
+	#@if bash
+	#@s="${s//\\/\\\\}"
+	#@s="${s//\"/\\\"}"
+	#@s="${s//${_E_NL}/\\n}"
+	#@s="${s//${_E_TAB}/\\t}"
+	#@s="${s//${_E_CR}/\\r}"
+	#@_E_JSON=''
+	#@while [[ ${s} == *[$'\001'-$'\037']* ]]; do
+	#@	pre="${s%%[$'\001'-$'\037']*}"
+	#@	printf -v c '\\u%04x' "'${s:${#pre}:1}"
+	#@	s="${s:${#pre}+1}"
+	#@	_E_JSON="${_E_JSON}${pre}${c}"
+	#@done
+	#@_E_JSON="${_E_JSON}${s}"
+	#@else
+	_E_JSON=''
+	while :; do
+		pre="${s%%[\"\\${_E_CTL}]*}"
+		[ "${pre}" = "${s}" ] && break
+		s="${s#"${pre}"}"
+		c="${s%"${s#?}"}"
+		s="${s#?}"
+		case "${c}" in
+			'"') c='\"';;
+			'\') c='\\';;
+			"${_E_NL}") c='\n';;
+			"${_E_TAB}") c='\t';;
+			"${_E_CR}") c='\r';;
+			*)
+				# The code is the place in _E_CTL
+				n="${_E_CTL%%"${c}"*}"
+				n=$(( ${#n} + 1 ))
+				lo=$(( n % 16 ))
+				case "${lo}" in
+					10) lo=a;; 11) lo=b;; 12) lo=c;;
+					13) lo=d;; 14) lo=e;; 15) lo=f;;
+				esac
+				c="\\u00$(( n / 16 ))${lo}"
+				;;
+		esac
+		_E_JSON="${_E_JSON}${pre}${c}"
+	done
+	_E_JSON="${_E_JSON}${s}"
+	#@endif
+}
+
+#
+#    render a printf format as the terminal shows it, into _E_TEXT.
+#    Without a % or \ in it the format is the text, and no subshell
+#    is needed for it.
+# This is a private function.
+#
+_erender()
+{
+	#@if bash
+	#@printf -v _E_TEXT -- "$1"
+	#@else
+	case "$1" in
+		*[%\\]*)
+			# The x keeps the newlines at the end
+			_E_TEXT="$(printf -- "$1"; printf x)"
+			_E_TEXT="${_E_TEXT%x}"
+			;;
+		*) _E_TEXT="$1";;
+	esac
+	#@endif
+}
+
+#
+#    write one NDJSON record for an e-message to EINFO_JSON_FD, if set.
+#    $1 is the level, $2 the message, a printf format except for
+#    streams, and $3 extra members, already in JSON form with a leading
+#    comma.
+# This is a private function.
+#
+_ejson()
+{
+	[ -n "${EINFO_JSON_FD}" ] || return 0
+
+	local level="$1" msg="${2%\\n}" extra="$3" script
+
+	case "${extra}" in
+		*'"stream":true'*) ;;
+		*) _erender "${msg}"; msg="${_E_TEXT}";;
+	esac
+	_ectl
+	_ejson_escape "${0##*/}"
+	script="${_E_JSON}"
+	case "${msg}" in
+		*"${_E_ESC}"*) _enocolor "${msg}"; msg="${_E_PLAIN}";;
+	esac
+	_ejson_escape "${msg}"
+	_eclock
+
+	printf '{"level":"%s","msg":"%s","indent":%d,"script":"%s","time":%s%s}\n' \
+		"${level}" "${_E_JSON}" "${#RC_INDENTATION}" "${script}" \
+		"${_E_CLOCK:-null}" "${extra}" >&"${EINFO_JSON_FD}"
+}
+
+#
+#    get the uptime as "[   12.345]" into _E_STAMP, or nothing if
+#    there is no clock. A time from _eclock may be given instead.
+# This is a private function.
+#
+_estamp()
+{
+	local t="$1" s f
+
+	_E_STAMP=''
+	if [ -z "${t}" ]; then
+		_eclock || return 0
+		t="${_E_CLOCK}"
+	fi
+	s="    $(( t / 1000 ))"
+	f="00$(( t % 1000 ))"
+	_E_STAMP="[${s#"${s%?????}"}.${f#"${f%???}"}]"
+}
+
+#
+#    append a plain copy of a shown e-message to EINFO_LOGFILE, with
+#    the uptime and without colours, in a single O_APPEND write. The
+#    message is a printf format, as it is for the terminal. The ebegin
+#    line is only written by eend, together with the status, and with
+#    the time ebegin was called if given as a fourth argument. The
+#    others are those of _ejson.
+# This is a private function.
+#
+_elog()
+{
+	[ -n "${EINFO_LOGFILE}" ] || return 0
+
+	local msg="${2%\\n}"
+
+	case "$1:$3" in
+		begin:*|*'"stream":true'*) return 0;;
+		error:*) yesno "${EERROR_QUIET}" && return 0;;
+		end:*'"result":"ok"'*)
+			yesno "${EINFO_QUIET}" && return 0
+			msg="${msg:+${msg} ... }[ ok ]"
+			;;
+		end:*) msg="${msg:+${msg} ... }[ !! ]";;
+		*) yesno "${EINFO_QUIET}" && return 0;;
+	esac
+
+	_ectl
+	case "${msg}" in
+		*"${_E_ESC}"*) _enocolor "${msg}"; msg="${_E_PLAIN}";;
+	esac
+	_estamp "$4"
+	printf "${_E_STAMP} * ${RC_INDENTATION}${msg}\n" \
+		2>/dev/null >>"${EINFO_LOGFILE}"
+}
+
+#
+#    record an e-message event: count it per level and hand it to the
+#    enabled sinks. The arguments are those of _elog.
+# This is a private function.
+#
+_eevent()
+{
+	case "$1" in
+		info) yesno "${EINFO_QUIET}" || \
+			EINFO_COUNT_INFO=$(( EINFO_COUNT_INFO + 1 ));;
+		warn) yesno "${EINFO_QUIET}" || \
+			EINFO_COUNT_WARN=$(( EINFO_COUNT_WARN + 1 ));;
+		error) yesno "${EERROR_QUIET}" || \
+			EINFO_COUNT_ERROR=$(( EINFO_COUNT_ERROR + 1 ));;
+	esac
+	_ejson "$@"
+	_elog "$@"
+}
+
+#
+#    escape a string for a field of a tab separated line, result in
+#    _E_TSV. Only backslash, tab and newline are escaped.
+# This is a private function.
+#
+_etsv_escape()
+{
+	local s="$1" pre c
+	#@if bash
+	#@s="${s//\\/\\\\}"
+	#@s="${s//${_E_TAB}/\\t}"
+	#@_E_TSV="${s//${_E_NL}/\\n}"
+	#@else
+	_E_TSV=''
+	while :; do
+		pre="${s%%[\\${_E_NL}${_E_TAB}]*}"
+		[ "${pre}" = "${s}" ] && break
+		s="${s#"${pre}"}"
+		c="${s%"${s#?}"}"
+		s="${s#?}"
+		case "${c}" in
+			'\') c='\\';;
+			"${_E_NL}") c='\n';;
+			*) c='\t';;
+		esac
+		_E_TSV="${_E_TSV}${pre}${c}"
+	done
+	_E_TSV="${_E_TSV}${s}"
+	#@endif
+}
+
+#
+#    append a finished span to the boot-wide EINFO_BLAME_FILE as one
+#    tab separated line of start, duration, retval, pid, script and
+#    message, in a single O_APPEND write. Read it back with eblame.
+# This is a private function.
+#
+_eblame()
+{
+	local file="${EINFO_BLAME_FILE:-/run/gentoo-functions/blame}" msg="$4"
+	local name
+
+	if [ -z "${_E_BLAME_DIR}" ]; then
+		_E_BLAME_DIR="${file%/*}"
+		[ -d "${_E_BLAME_DIR}" ] || mkdir -p "${_E_BLAME_DIR}" 2>/dev/null
+	fi
+
+	_ectl
+	case "${msg}" in
+		*"${_E_ESC}"*) _enocolor "${msg}"; msg="${_E_PLAIN}";;
+	esac
+	_etsv_escape "${RC_SVCNAME:-${0##*/}}"
+	name="${_E_TSV}"
+	_etsv_escape "${msg}"
+
+	printf '%s\t%s\t%s\t%s\t%s\t%s\n' "$1" "$2" "$3" "$$" \
+		"${name}" "${_E_TSV}" 2>/dev/null >>"${file}"
+}
+
+#
+#    format a duration in milliseconds as seconds, result in _E_SECS.
+# This is a private function.
+#
+_esecs()
+{
+	local f="00$(( $1 % 1000 ))"
+	_E_SECS="$(( $1 / 1000 )).${f#"${f%???}"}s"
+}
+
+#
+#    print an informative message (without a newline)
+# This is a private function.
+#
+_einfon()
+{
+	if yesno "${EINFO_QUIET}"; then
+		return 0
+	fi
+	if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
+		_eout "\n"
+	fi
+	_eout " ${GOOD}*${NORMAL} ${RC_INDENTATION}$*"
+	LAST_E_CMD="einfon"
+	return 0
+}
+
+#
+#    show an informative message (without a newline)
+#
+einfon()
+{
+	_eevent info "$*"
+	_einfon "$*"
+}
+
+#
+#    show an informative message (with a newline)
+#
+einfo()
+{
+	einfon "$*\n"
+	LAST_E_CMD="einfo"
+	return 0
+}
+
+#
+#    show a warning message (without a newline) and log it
+#
+ewarnn()
+{
+	_eevent warn "$*"
+	if yesno "${EINFO_QUIET}"; then
+		return 0
+	else
+		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
+			_eerr "\n"
+		fi
+		_eerr " ${WARN}*${NORMAL} ${RC_INDENTATION}$*"
+	fi
+
+	local name="${0##*/}"
+	# Log warnings to system log
+	_E_EFUNC="ewarnn"
+	esyslog "daemon.warning" "${name}" "$*"
+
+	LAST_E_CMD="ewarnn"
+	return 0
+}
+
+#
+#    show a warning message (with a newline) and log it
+#
+ewarn()
+{
+	_eevent warn "$*"
+	if yesno "${EINFO_QUIET}"; then
+		return 0
+	else
+		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
+			_eerr "\n"
+		fi
+		_eerr " ${WARN}*${NORMAL} ${RC_INDENTATION}$*\n"
+	fi
+
+	local name="${0##*/}"
+	# Log warnings to system log
+	_E_EFUNC="ewarn"
+	esyslog "daemon.warning" "${name}" "$*"
+
+	LAST_E_CMD="ewarn"
+	return 0
+}
+
+#
+#    show an error message (without a newline) and log it
+#
+eerrorn()
+{
+	_eevent error "$*"
+	if yesno "${EERROR_QUIET}"; then
+		return 1
+	else
+		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
+			_eerr "\n"
+		fi
+		_eerr " ${BAD}*${NORMAL} ${RC_INDENTATION}$*"
+	fi
+
+	local name="${0##*/}"
+	# Log errors to system log
+	_E_EFUNC="eerrorn"
+	esyslog "daemon.err" "rc-scripts" "$*"
+
+	LAST_E_CMD="eerrorn"
+	return 1
+}
+
+#
+#    show an error message (with a newline) and log it
+#
+eerror()
+{
+	_eevent error "$*"
+	if yesno "${EERROR_QUIET}"; then
+		return 1
+	else
+		if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
+			_eerr "\n"
+		fi
+		_eerr " ${BAD}*${NORMAL} ${RC_INDENTATION}$*\n"
+	fi
+
+	local name="${0##*/}"
+	# Log errors to system log
+	_E_EFUNC="eerror"
+	esyslog "daemon.err" "rc-scripts" "$*"
+
+	LAST_E_CMD="eerror"
+	return 1
+}
+
+#
+#    show each line of the given files, or of stdin, as a message of
+#    the given level in a single pass. The text is not treated as a
+#    format, and lines are never held in shell variables.
+#    _estream level colour fd logger-priority quiet-variable [file]...
+#    Warnings and errors also go to logger when EINFO_LOG is set.
+# This is a private function.
+#
+_estream()
+{
+	local level="$1" colour="$2" fd="$3" pri="$4" quiet="$5" line f
+	shift 5
+
+	_eevent "${level}" "${*:--}" ',"stream":true'
+	if yesno "${quiet}"; then
+		# Do not leave a writer blocked on a full pipe
+		[ $# -eq 0 ] && set -- -
+		for f in "$@"; do
+			if [ "${f}" = "-" ]; then
+				cat >/dev/null
+				break
+			fi
+		done
+		return 0
+	fi
+	if ! yesno "${RC_ENDCOL}" && [ "${LAST_E_CMD}" = "ebegin" ]; then
+		printf "\n" >&"${fd}"
+	fi
+	LAST_E_CMD="${level}_stream"
+
+	_E_PREFIX=" ${colour}*${NORMAL} ${RC_INDENTATION}"
+	_E_LOGTAG=''
+	if [ -n "${pri}" ] && [ -n "${EINFO_LOG}" ] && \
+		command -v logger >/dev/null 2>&1; then
+		_E_LOGTAG="${0##*/}"
+		[ "${level}" = error ] && _E_LOGTAG="rc-scripts"
+	fi
+
+	# The lines also go to EINFO_LOGFILE, stamped with the start time
+	_E_LOGPREFIX=''
+	if [ -n "${EINFO_LOGFILE}" ]; then
+		_estamp
+		_E_LOGPREFIX="${_E_STAMP} * ${RC_INDENTATION}"
+	fi
+
+	# awk runs the logger through sh -c, so the tag is quoted for it.
+	# The files are read through cat, as awk would take operands with
+	# a "=" in them for assignments.
+	if command -v awk >/dev/null 2>&1; then
+		[ $# -eq 0 ] && set -- -
+		cat -- "$@" | \
+		_E_PREFIX="${_E_PREFIX}" _E_LOGPRI="${pri}" _E_LOGTAG="${_E_LOGTAG}" \
+		_E_LOGFILE="${EINFO_LOGFILE}" _E_LOGPREFIX="${_E_LOGPREFIX}" awk '
+			function quote(s) {
+				gsub(/\047/, "\047\\\047\047", s)
+				return "\047" s "\047"
+			}
+			BEGIN {
+				p = ENVIRON["_E_PREFIX"]; lf = ENVIRON["_E_LOGFILE"]
+				lp = ENVIRON["_E_LOGPREFIX"]; lc = ""
+				if (ENVIRON["_E_LOGTAG"] != "")
+					lc = "logger -p " quote(ENVIRON["_E_LOGPRI"]) \
+						" -t " quote(ENVIRON["_E_LOGTAG"])
+			}
+			{
+				print p $0
+				if (lc != "")
+					print $0 | lc
+				if (lf != "")
+					print lp $0 >> lf
+			}' >&"${fd}"
+		return
+	fi
+
+	# Without awk, line by line in the shell
+	[ $# -eq 0 ] && set -- -
+	for f in "$@"; do
+		if [ "${f}" = "-" ]; then
+			f=/dev/stdin
+		elif [ ! -r "${f}" ]; then
+			printf '%s: cannot read %s\n' "${level}_stream" "${f}" >&2
+			return 1
+		fi
+		while IFS= read -r line || [ -n "${line}" ]; do
+			printf '%s%s\n' "${_E_PREFIX}" "${line}"
+			[ -n "${_E_LOGTAG}" ] && \
+				logger -p "${pri}" -t "${_E_LOGTAG}" -- "${line}"
+			[ -n "${EINFO_LOGFILE}" ] && \
+				printf '%s%s\n' "${_E_LOGPREFIX}" "${line}" \
+					2>/dev/null >>"${EINFO_LOGFILE}"
+		done <"${f}" >&"${fd}"
+	done
+	return 0
+}
+
+#
+#    show each line of the given files, or of stdin, as einfo would
+#
+einfo_stream()
+{
+	_estream info "${GOOD}" "${_E_OUT}" '' EINFO_QUIET "$@"
+}
+
+#
+#    show each line of the given files, or of stdin, as ewarn would
+#
+ewarn_stream()
+{
+	_estream warn "${WARN}" "${_E_ERR}" daemon.warning EINFO_QUIET "$@"
+}
+
+#
+#    show each line of the given files, or of stdin, as eerror would
+#
+eerror_stream()
+{
+	_estream error "${BAD}" "${_E_ERR}" daemon.err EERROR_QUIET "$@"
+	return 1
+}
+
+#
+#    show a message indicating the start of a process
+#
+ebegin()
+{
+	local msg="$*" start=
+
+	# Open a span for the matching eend, timed if anyone is interested
+	if yesno "${EINFO_TIMING}" || [ -n "${EINFO_SUMMARY}" ] || \
+		yesno "${EINFO_BLAME}" || [ -n "${EINFO_LOGFILE}" ]; then
+		_eclock && start="${_E_CLOCK}"
+	fi
+	_E_SPANS="${_E_SPANS}${_E_NL}${start}${_E_TAB}${msg}"
+
+	_eevent begin "${msg}"
+	if yesno "${EINFO_QUIET}"; then
+		return 0
+	fi
+
+	msg="${msg} ..."
+	_einfon "${msg}"
+	if yesno "${RC_ENDCOL}"; then
+		_eout "\n"
+	fi
+
+	LAST_E_LEN="$(( 3 + ${#RC_INDENTATION} + ${#msg} ))"
+	LAST_E_CMD="ebegin"
+	return 0
+}
+
+#
+#    tell the boot splash to stop, at most once per session. A splash
+#    helper listening on the RC_SPLASH_FIFO pipe gets a "stop" line,
+#    otherwise rc_splash is run if it is defined at all.
+# This is a private function.
+#
+_esplash_stop()
+{
+	yesno "${RC_SPLASH_STOPPED:-no}" && return 0
+	RC_SPLASH_STOPPED="yes"; export RC_SPLASH_STOPPED
+
+	if [ -n "${RC_SPLASH_FIFO}" ] && [ -p "${RC_SPLASH_FIFO}" ] ; then
+		# Opening read-write never blocks, even with nobody listening
+		printf 'stop\n' 2>/dev/null 1<>"${RC_SPLASH_FIFO}"
+	elif command -v rc_splash >/dev/null 2>&1 ; then
+		if [ -c /dev/null ] ; then
+			rc_splash "stop" >/dev/null 2>&1 &
+		else
+			rc_splash "stop" &
+		fi
+	fi
+	return 0
+}
+
+#
+#    indicate the completion of process, called from eend/ewend
+#    if error, show errstr via efunc
+#
+#    This function is private to functions.sh.  Do not call it from a
+#    script.
+#
+_eend()
+{
+	local retval="${1:-0}" efunc="${2:-eerror}" msg span start
+	local elapsed= extra= tm=
+	shift 2
+
+	# Close the span opened by the matching ebegin
+	span="${_E_SPANS##*"${_E_NL}"}"
+	_E_SPANS="${_E_SPANS%"${_E_NL}"*}"
+	start="${span%%"${_E_TAB}"*}"
+	span="${span#*"${_E_TAB}"}"
+	if [ -n "${start}" ] && _eclock; then
+		elapsed=$(( _E_CLOCK - start ))
+		extra=",\"elapsed\":${elapsed}"
+		if yesno "${EINFO_TIMING}"; then
+			_esecs "${elapsed}"
+			tm="(${_E_SECS}) "
+		fi
+		if [ -n "${EINFO_SUMMARY}" ]; then
+			_E_SPANS_DONE="${_E_SPANS_DONE}${_E_NL}${elapsed}${_E_TAB}${retval}${_E_TAB}${span}"
+			[ "${retval}" = 0 ] || _E_SPANS_FAILED="yes"
+		fi
+		yesno "${EINFO_BLAME}" && \
+			_eblame "${start}" "${elapsed}" "${retval}" "${span}"
+	fi
+
+	if [ "${retval}" = "0" ]; then
+		_eevent end "${span}" ",\"result\":\"ok\",\"retval\":0${extra}" \
+			"${start}"
+		yesno "${EINFO_QUIET}" && return 0
+		msg="${BRACKET}[ ${GOOD}ok${BRACKET} ]${NORMAL}"
+	else
+		_esplash_stop
+		if [ -n "$*" ] ; then
+			${efunc} "$*"
+		fi
+		# Anything but a plain number goes into JSON as a string
+		case "${retval}" in
+			*[!0-9]*|0?*)
+				_ectl
+				_ejson_escape "${retval}"
+				extra=",\"retval\":\"${_E_JSON}\"${extra}"
+				;;
+			*) extra=",\"retval\":${retval}${extra}";;
+		esac
+		_eevent end "${span}" ",\"result\":\"fail\"${extra}" "${start}"
+		msg="${BRACKET}[ ${BAD}!!${BRACKET} ]${NORMAL}"
+	fi
+
+	if yesno "${RC_ENDCOL}" && [ -n "${tm}" ]; then
+		_eout "\033[A\033[$(( COLS - 8 - ${#tm} ))C  ${tm}${msg}\n"
+	elif yesno "${RC_ENDCOL}"; then
+		_eout "${ENDCOL}  ${msg}\n"
+	else
+		[ "${LAST_E_CMD}" = ebegin ] || LAST_E_LEN=0
+		_eout "%$(( COLS - LAST_E_LEN - 6 - ${#tm} ))s%s%b\n" '' "${tm}" "${msg}"
+	fi
+
+	return ${retval}
+}
+
+#
+#    indicate the completion of process
+#    if error, show errstr via eerror
+#
+eend()
+{
+	local retval="${1:-0}"
+	[ $# -eq 0 ] || shift
+
+	_eend "${retval}" eerror "$*"
+
+	LAST_E_CMD="eend"
+	return ${retval}
+}
+
+#
+#    indicate the completion of process
+#    if error, show errstr via ewarn
+#
+ewend()
+{
+	local retval="${1:-0}"
+	[ $# -eq 0 ] || shift
+
+	_eend "${retval}" ewarn "$*"
+
+	LAST_E_CMD="ewend"
+	return ${retval}
+}
+
+#
+#    summarise the EINFO_SUMMARY slowest spans, all failed spans and the
+#    counts of the messages shown. Run on EXIT when EINFO_SUMMARY is set,
+#    or from the script's own EXIT trap.
+#
+esummary()
+{
+	local elapsed retval msg spans="${_E_SPANS_DONE#"${_E_NL}"}"
+	local counts="${EINFO_COUNT_INFO} info, ${EINFO_COUNT_WARN} warning"
+	counts="${counts} and ${EINFO_COUNT_ERROR} error messages"
+
+	if [ -n "${spans}" ]; then
+		einfo "Slowest steps:"
+		eindent
+		printf '%s\n' "${spans}" | sort -t "${_E_TAB}" -k 1,1nr | \
+			head -n "${EINFO_SUMMARY}" | \
+			while IFS="${_E_TAB}" read -r elapsed retval msg; do
+				_esecs "${elapsed}"
+				einfo "${_E_SECS}  ${msg}"
+			done
+		eoutdent
+
+		if [ "${_E_SPANS_FAILED}" = "yes" ]; then
+			einfo "Failed steps:"
+			eindent
+			printf '%s\n' "${spans}" | \
+				while IFS="${_E_TAB}" read -r elapsed retval msg; do
+					[ "${retval}" = 0 ] || einfo "${msg} (${retval})"
+				done
+			eoutdent
+		fi
+	fi
+
+	einfo "${counts}"
+}
+
+# Write to the console through econsole if asked to
+if yesno "${EINFO_NONBLOCK:-no}" && [ "${_E_OUT}" = 1 ]; then
+	_enonblock || true
+fi
+
+# vim:ts=4
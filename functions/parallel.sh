@@ -0,0 +1,200 @@
+# Copyright 2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Running jobs concurrently: eparallel.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+#
+#    count the CPUs into _E_NCPUS without forking, 1 if unknown.
+# This is a private function.
+#
+_encpus()
+{
+	local c
+
+	_E_NCPUS=0
+	for c in /sys/devices/system/cpu/cpu[0-9]*; do
+		[ -e "${c}" ] && _E_NCPUS=$(( _E_NCPUS + 1 ))
+	done
+	[ "${_E_NCPUS}" -gt 0 ] || _E_NCPUS=1
+}
+
+#
+#    wait for the oldest job in _E_JOBS and report it with ebegin,
+#    its output and eend. Returns the job's exit status.
+# This is a private function.
+#
+_eparallel_reap()
+{
+	local job="${_E_JOBS#"${_E_NL}"}" pid file retval
+
+	job="${job%%"${_E_NL}"*}"
+	_E_JOBS="${_E_JOBS#"${_E_NL}${job}"}"
+	pid="${job%%"${_E_TAB}"*}"
+	job="${job#*"${_E_TAB}"}"
+	file="${job%%"${_E_TAB}"*}"
+	job="${job#*"${_E_TAB}"}"
+
+	# A trapped signal, such as WINCH with RC_TRACK_WINCH, ends wait
+	# early with more than 128, while the job goes on
+	while : ; do
+		wait "${pid}"
+		retval=$?
+		[ "${retval}" -gt 128 ] && kill -0 "${pid}" 2>/dev/null || break
+	done
+	ebegin "${job}"
+	[ -s "${file}" ] && cat "${file}" >&"${_E_OUT}"
+	eend "${retval}"
+}
+
+#
+#    the eparallel loop with a status board listing the running jobs.
+#    Jobs touch a marker file when they are done, so that finished ones
+#    are noticed without blocking in wait, and write their number into
+#    a FIFO, which the loop blocks on while nothing changes. Arguments
+#    are the number of jobs, the output directory and the job list.
+# This is a private function.
+#
+_eparallel_board()
+{
+	local jobs="$1" dir="$2" n=0 next=1 running i failed=0 changed fd=
+	shift 2
+
+	# Held read-write, so neither side ever waits to open it
+	if mkfifo "${dir}/done" 2>/dev/null && _efreefd ; then
+		fd="${_E_FD}"
+		eval "exec ${fd}<>\"\${dir}/done\""
+	fi
+
+	eboard_start
+	_E_JOBS=''
+	while [ $# -gt 0 ] || [ "${next}" -le "${n}" ] ; do
+		# Count what is still running, dropping it from the board
+		# once it is done
+		running=0
+		i="${next}"
+		while [ "${i}" -le "${n}" ] ; do
+			if [ -e "${dir}/${i}.done" ] ; then
+				eboard_del "${i}"
+			else
+				running=$(( running + 1 ))
+			fi
+			i=$(( i + 1 ))
+		done
+
+		changed=
+		while [ $# -gt 0 ] && [ "${running}" -lt "${jobs}" ] ; do
+			n=$(( n + 1 ))
+			(
+				(
+					[ -z "${fd}" ] || eval "exec ${fd}>&-"
+					eval "$2"
+				) </dev/null >"${dir}/${n}" 2>&1
+				i=$?
+				: >"${dir}/${n}.done"
+				[ -z "${fd}" ] || printf '%s\n' "${n}" >&"${fd}"
+				exit ${i}
+			) &
+			_E_JOBS="${_E_JOBS}${_E_NL}$!${_E_TAB}${dir}/${n}${_E_TAB}$1"
+			eboard_set "${n}" "$1"
+			running=$(( running + 1 ))
+			changed=yes
+			shift 2
+		done
+
+		# Report finished jobs above the board, in order
+		while [ "${next}" -le "${n}" ] && [ -e "${dir}/${next}.done" ] ; do
+			eboard_clear
+			_eparallel_reap || failed=$(( failed + 1 ))
+			next=$(( next + 1 ))
+			changed=yes
+		done
+
+		if [ -n "${changed}" ] ; then
+			eboard_draw
+			continue
+		fi
+
+		# Nothing happens until a job is done: put up what a throttled
+		# draw left out and wait for it
+		eboard_draw -f
+		# If a trapped signal cuts these short, the markers are looked
+		# at again and nothing is lost
+		if [ -n "${fd}" ] ; then
+			read -r i <&"${fd}"
+		else
+			sleep 1
+		fi
+	done
+	eboard_stop
+	[ -z "${fd}" ] || eval "exec ${fd}<&-"
+
+	[ "${failed}" -gt 255 ] && failed=255
+	return ${failed}
+}
+
+#
+#    run jobs concurrently and report each one with ebegin/eend, in the
+#    order given, together with its output.
+#    eparallel [-j jobs] message command [message command]...
+#    Each command is evaluated in a subshell. At most jobs commands run
+#    at once, as many as there are CPUs by default. Jobs are reported
+#    oldest first, and a new one is started when the oldest is done.
+#    With EINFO_BOARD=yes the running jobs are listed on a status
+#    board instead, and a new one starts as soon as any job is done.
+#    Returns the number of failed jobs, at most 255.
+#
+eparallel()
+{
+	local jobs= dir n=0 running=0 failed=0
+
+	case "$1" in
+		-j) jobs="$2"; shift 2;;
+		-j*) jobs="${1#-j}"; shift;;
+	esac
+	[ "$1" = "--" ] && shift
+	if [ $(( $# % 2 )) -ne 0 ] ; then
+		printf 'eparallel: every job needs a message and a command\n' >&2
+		return 255
+	fi
+	if [ -z "${jobs}" ] ; then
+		_encpus
+		jobs="${_E_NCPUS}"
+	fi
+	[ "${jobs}" -gt 0 ] 2>/dev/null || jobs=1
+
+	dir="$(mktemp -d "${TMPDIR:-/tmp}/eparallel.XXXXXX")" || return 255
+	if yesno "${EINFO_BOARD:-no}" ; then
+		_eload board && _eparallel_board "${jobs}" "${dir}" "$@"
+		failed=$?
+		rm -rf "${dir}"
+		return ${failed}
+	fi
+
+	_E_JOBS=''
+	while [ $# -gt 0 ] ; do
+		if [ "${running}" -ge "${jobs}" ] ; then
+			_eparallel_reap || failed=$(( failed + 1 ))
+			running=$(( running - 1 ))
+		fi
+		n=$(( n + 1 ))
+		( eval "$2" ) </dev/null >"${dir}/${n}" 2>&1 &
+		_E_JOBS="${_E_JOBS}${_E_NL}$!${_E_TAB}${dir}/${n}${_E_TAB}$1"
+		running=$(( running + 1 ))
+		shift 2
+	done
+	while [ "${running}" -gt 0 ] ; do
+		_eparallel_reap || failed=$(( failed + 1 ))
+		running=$(( running - 1 ))
+	done
+	rm -rf "${dir}"
+
+	[ "${failed}" -gt 255 ] && failed=255
+	return ${failed}
+}
+
+# vim:ts=4
@@ -0,0 +1,103 @@
+# Copyright 2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Progress reporting for long ebegin/eend steps: eprogress.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+# Progress is drawn by the message functions
+_eload output
+
+#
+#    start a step whose progress will be shown, like ebegin.
+#
+eprogress_start()
+{
+	_E_PROG_LAST=''
+	_E_PROG_SHOWN=''
+	ebegin "$@"
+}
+
+#
+#    show the progress of the step started by eprogress_start.
+#    eprogress_update count [total]
+#    On vt and pty consoles it is drawn in place of the [ ok ], as
+#    "[ 42%]" or, without a total, the count. Redraws happen at most
+#    every EINFO_PROGRESS_INTERVAL milliseconds (250 by default), so
+#    this is cheap to call for every item. Without ENDCOL, as on
+#    serial consoles, only every quarter is appended to the ebegin
+#    line, or the count every 10 seconds if there is no total.
+#
+eprogress_update()
+{
+	local count="${1:-0}" total="$2" pct= field
+
+	yesno "${EINFO_QUIET}" && return 0
+	# Anything printed since ebegin would be overwritten
+	[ "${LAST_E_CMD}" = "ebegin" ] || return 0
+
+	if [ -n "${total}" ] && [ "${total}" -gt 0 ]; then
+		pct=$(( count * 100 / total ))
+		[ "${pct}" -gt 100 ] && pct=100
+	fi
+
+	if ! yesno "${RC_ENDCOL}"; then
+		if [ -n "${pct}" ]; then
+			field=$(( pct / 25 * 25 ))
+			[ "${field}" -gt 0 ] && [ "${field}" -lt 100 ] || return 0
+			[ "${field}" = "${_E_PROG_SHOWN}" ] && return 0
+			_E_PROG_SHOWN="${field}"
+			field="${field}%"
+		else
+			_eclock || return 0
+			if [ -z "${_E_PROG_LAST}" ]; then
+				_E_PROG_LAST="${_E_CLOCK}"
+				return 0
+			fi
+			[ $(( _E_CLOCK - _E_PROG_LAST )) -lt 10000 ] && return 0
+			_E_PROG_LAST="${_E_CLOCK}"
+			field="${count}"
+		fi
+		_eout " %s" "${field}"
+		LAST_E_LEN=$(( LAST_E_LEN + 1 + ${#field} ))
+		return 0
+	fi
+
+	if _eclock; then
+		[ -n "${_E_PROG_LAST}" ] && \
+			[ $(( _E_CLOCK - _E_PROG_LAST )) -lt "${EINFO_PROGRESS_INTERVAL:-250}" ] && \
+			return 0
+		_E_PROG_LAST="${_E_CLOCK}"
+	fi
+
+	# Four characters, as wide as the "ok" in [ ok ] with its spaces
+	if [ -n "${pct}" ]; then
+		field="   ${pct}%"
+	elif [ "${count}" -lt 10000 ]; then
+		field="    ${count}"
+	elif [ "${count}" -lt 1000000 ]; then
+		field="   $(( count / 1000 ))k"
+	else
+		field="   $(( count / 1000000 ))M"
+	fi
+	field="${field#"${field%????}"}"
+	[ "${field}" = "${_E_PROG_SHOWN}" ] && return 0
+	_E_PROG_SHOWN="${field}"
+
+	_eout "${ENDCOL}  ${BRACKET}[${NORMAL}%s${BRACKET}]${NORMAL}\n" "${field}"
+}
+
+#
+#    end the step started by eprogress_start, like eend.
+#
+eprogress_finish()
+{
+	_E_PROG_LAST=''
+	_E_PROG_SHOWN=''
+	eend "$@"
+}
+
+# vim:ts=4
@@ -0,0 +1,91 @@
+# Copyright 1999-2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Terminal and colour setup.
+# It is loaded by functions.sh on first use and should not be sourced
+# directly. All functions in this file should be written in POSIX sh.
+# Please do not use bashisms.
+#
+
+#
+#    compute COLS and ENDCOL from the given width, or from the size of
+#    the terminal if no width is given.
+#    This is a private function.
+#
+_esetcols()
+{
+	COLS="${1:-0}"
+	# sh cannot ask the terminal for its size, so stty is run, in the
+	# one fork of the command substitution. consoletype is no help: an
+	# exit status cannot hold the width. Without a terminal on stdin
+	# stty would fail anyway, and the fork is saved.
+	if [ "$COLS" -eq 0 ] && [ -t 0 ] ; then
+		COLS="$(stty size 2>/dev/null)"
+		COLS="${COLS#* }"
+	fi
+	[ -z "$COLS" ] && COLS=80
+	[ "$COLS" -gt 0 ] || COLS=80	# width of [ ok ] == 7
+
+	if yesno "${RC_ENDCOL}"; then
+		ENDCOL='\033[A\033['$(( COLS - 8 ))'C'
+	else
+		ENDCOL=''
+	fi
+}
+
+# Cache the CONSOLETYPE - this is important as backgrounded shells don't
+# have a TTY. rc unsets it at the end of running so it shouldn't hang
+# around. The type comes back as the exit code of "consoletype status",
+# which saves the subshell and pipe of reading its output. Consoles only
+# that mode tells apart (hvc, USB serial, virtual) are all serial here,
+# and an older consoletype prints a word we discard and returns 0 to 3.
+if [ -z "${CONSOLETYPE}" ] ; then
+	consoletype status >/dev/null 2>&1
+	case $? in
+		0) CONSOLETYPE="vt";;
+		1|4|5|6) CONSOLETYPE="serial";;
+		2) CONSOLETYPE="pty";;
+		3) CONSOLETYPE="unknown";;
+		*) CONSOLETYPE="";;
+	esac
+	export CONSOLETYPE
+fi
+if [ "${CONSOLETYPE}" = "serial" ] ; then
+	RC_NOCOLOR="yes"
+	RC_ENDCOL="no"
+fi
+
+# Setup COLS and ENDCOL so eend can line up the [ ok ]
+_esetcols "${COLUMNS}"          # bash's internal COLUMNS variable
+
+# Follow window resizes if asked to. The trap only fires when the size
+# really changes, so printing messages costs nothing extra.
+if yesno "${RC_TRACK_WINCH:-no}"; then
+	trap '_esetcols' WINCH
+fi
+
+# Setup the colors so our messages all look pretty
+if yesno "${RC_NOCOLOR}"; then
+	unset GOOD WARN BAD NORMAL HILITE BRACKET
+elif (command -v tput && tput colors) >/dev/null 2>&1; then
+	GOOD="$(tput sgr0)$(tput bold)$(tput setaf 2)"
+	WARN="$(tput sgr0)$(tput bold)$(tput setaf 3)"
+	BAD="$(tput sgr0)$(tput bold)$(tput setaf 1)"
+	HILITE="$(tput sgr0)$(tput bold)$(tput setaf 6)"
+	BRACKET="$(tput sgr0)$(tput bold)$(tput setaf 4)"
+	NORMAL="$(tput sgr0)"
+else
+	GOOD=$(printf '\033[32;01m')
+	WARN=$(printf '\033[33;01m')
+	BAD=$(printf '\033[31;01m')
+	HILITE=$(printf '\033[36;01m')
+	BRACKET=$(printf '\033[34;01m')
+	NORMAL=$(printf '\033[0m')
+fi
+
+# If we made it this far, the setup succeeded, so don't let failures
+# from earlier commands (like `tput`) screw up the $? value.
+:
+
+# vim:ts=4
@@ -0,0 +1,56 @@
+# Copyright 2026 Gentoo Authors
+# Distributed under the terms of the GNU General Public License v2
+
+#
+# Generate the copy of functions.sh, or of one of its modules, meant
+# for the shell given as -v variant=<shell>.
+#
+# Lines between "#@if <shell>..." and "#@else" or "#@endif" are
+# commented out with "#@" in the source. For the listed shells they are
+# uncommented and the "#@else" part is dropped, for all other shells
+# the reverse happens. @VARIANT@ is replaced by the shell's name.
+#
+
+function directive(line)
+{
+	sub(/^[ \t]*#@/, "", line)
+	return line
+}
+
+/^[ \t]*#@if[ \t]/ {
+	n = split(directive($0), shells)
+	active = 0
+	for (i = 2; i <= n; i++)
+		if (shells[i] == variant)
+			active = 1
+	state = "if"
+	next
+}
+
+/^[ \t]*#@else[ \t]*$/ {
+	state = "else"
+	next
+}
+
+/^[ \t]*#@endif[ \t]*$/ {
+	state = ""
+	next
+}
+
+state == "if" {
+	if (active) {
+		line = $0
+		sub(/#@/, "", line)
+		gsub(/@VARIANT@/, variant, line)
+		print line
+	}
+	next
+}
+
+state == "else" && active {
+	next
+}
+
+{
+	print
+}
@@ -0,0 +1,206 @@
+/*
+ * newer-than.c
+ * helper for is_older_than in functions.sh: returns 0 as soon as any
+ * of the given files, or anything below the given directories, is
+ * newer than the reference file, and 1 otherwise. With -p the newer
+ * file that was found is printed. It returns 2 if it runs out of
+ * memory, for is_older_than to walk the trees itself.
+ *
+ * Directories are read by a small pool of threads sharing one stack
+ * of pending directories, so large trees are spread over all CPUs.
+ *
+ * Copyright 2026 Gentoo Authors
+ * Distributed under the terms of the GNU General Public License v2
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define MAX_THREADS 8
+
+struct work {
+	struct work *next;
+	char path[];
+};
+
+static struct timespec ref_time;
+static int ref_missing;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wakeup = PTHREAD_COND_INITIALIZER;
+static struct work *pending;
+static int busy;
+static atomic_int found;
+static char *witness;
+
+/* same test as `[ file -nt ref ]`, on an already stat'ed file */
+static inline int is_newer(const struct stat *sb)
+{
+	if (ref_missing)
+		return 1;
+	if (sb->st_mtim.tv_sec != ref_time.tv_sec)
+		return sb->st_mtim.tv_sec > ref_time.tv_sec;
+	return sb->st_mtim.tv_nsec > ref_time.tv_nsec;
+}
+
+static void push(const char *dir, const char *name)
+{
+	size_t dlen = strlen(dir), nlen = name ? strlen(name) : 0;
+	struct work *w = malloc(sizeof(*w) + dlen + nlen + 2);
+
+	/* A tree left out could hide the newer file */
+	if (w == NULL) {
+		perror("newer-than");
+		exit(2);
+	}
+	memcpy(w->path, dir, dlen);
+	if (name) {
+		w->path[dlen] = '/';
+		memcpy(w->path + dlen + 1, name, nlen + 1);
+	} else
+		w->path[dlen] = '\0';
+
+	pthread_mutex_lock(&lock);
+	w->next = pending;
+	pending = w;
+	pthread_cond_signal(&wakeup);
+	pthread_mutex_unlock(&lock);
+}
+
+static void finish(const char *dir, const char *name)
+{
+	pthread_mutex_lock(&lock);
+	if (!found && asprintf(&witness, "%s/%s", dir, name) < 0)
+		witness = NULL;
+	found = 1;
+	pthread_cond_broadcast(&wakeup);
+	pthread_mutex_unlock(&lock);
+}
+
+static void scan(const char *path)
+{
+	struct dirent *de;
+	struct stat sb, lsb;
+	DIR *dir;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	dir = fdopendir(fd);
+	if (dir == NULL) {
+		close(fd);
+		return;
+	}
+
+	while (!found && (de = readdir(dir)) != NULL) {
+		if (de->d_name[0] == '.' && (de->d_name[1] == '\0' ||
+		    (de->d_name[1] == '.' && de->d_name[2] == '\0')))
+			continue;
+		/* like -nt, compare what symlinks point to */
+		if (fstatat(fd, de->d_name, &sb, 0) < 0)
+			continue;
+		if (is_newer(&sb)) {
+			finish(path, de->d_name);
+			break;
+		}
+		/* but do not follow them into other trees */
+		if (!S_ISDIR(sb.st_mode))
+			continue;
+		if (de->d_type == DT_UNKNOWN &&
+		    (fstatat(fd, de->d_name, &lsb, AT_SYMLINK_NOFOLLOW) < 0 ||
+		     !S_ISDIR(lsb.st_mode)))
+			continue;
+		if (de->d_type == DT_DIR || de->d_type == DT_UNKNOWN)
+			push(path, de->d_name);
+	}
+	closedir(dir);
+}
+
+static void *worker(void *arg)
+{
+	struct work *w;
+
+	(void)arg;
+	pthread_mutex_lock(&lock);
+	for (;;) {
+		while (!found && pending == NULL && busy > 0)
+			pthread_cond_wait(&wakeup, &lock);
+		if (found || pending == NULL)
+			break;
+		w = pending;
+		pending = w->next;
+		busy++;
+		pthread_mutex_unlock(&lock);
+
+		scan(w->path);
+		free(w);
+
+		pthread_mutex_lock(&lock);
+		if (--busy == 0 && pending == NULL)
+			pthread_cond_broadcast(&wakeup);
+	}
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_t threads[MAX_THREADS];
+	int i, opt, print = 0, nthreads = 0;
+	long ncpu;
+	struct stat sb;
+
+	while ((opt = getopt(argc, argv, "+p")) != -1) {
+		if (opt != 'p')
+			goto usage;
+		print = 1;
+	}
+	if (optind >= argc)
+		goto usage;
+
+	if (stat(argv[optind], &sb) == 0)
+		ref_time = sb.st_mtim;
+	else
+		ref_missing = 1;
+
+	for (i = optind + 1; i < argc; i++) {
+		if (stat(argv[i], &sb) < 0)
+			continue;
+		if (is_newer(&sb)) {
+			if (print)
+				puts(argv[i]);
+			return 0;
+		}
+		if (S_ISDIR(sb.st_mode))
+			push(argv[i], NULL);
+	}
+	if (pending == NULL)
+		return 1;
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu > MAX_THREADS)
+		ncpu = MAX_THREADS;
+	for (i = 1; i < ncpu; i++)
+		if (pthread_create(&threads[nthreads], NULL, worker, NULL) == 0)
+			nthreads++;
+	worker(NULL);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+
+	if (found && print && witness)
+		puts(witness);
+	return found ? 0 : 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-p] <reference> [file|dir]...\n", argv[0]);
+	return 2;
+}